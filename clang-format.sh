@@ -1 +1 @@
-find src/ -iname '*.h' -o -iname '*.cpp' | xargs clang-format -i
\ No newline at end of file
+find src/ tests/ -iname '*.h' -o -iname '*.cpp' | xargs clang-format -i
\ No newline at end of file
@@ -3,4 +3,7 @@ mkdir dockerbuild
 cd dockerbuild
 pwd
 python ../configure.py --enable-optimize --sdks cs2
-ambuild
\ No newline at end of file
+ambuild || exit 1
+
+# Offline checks from tests/, fails the build if any of them do
+"$(find tests -type f -name cs2fixes_tests | head -n 1)"
@@ -21,7 +21,9 @@
 
 #include <cstdint>
 
-#define CS2FIXES_INTERFACE "CS2Fixes001"
+// Bumped whenever methods are added, consumers built against an older header can still query the version they know
+#define CS2FIXES_INTERFACE "CS2Fixes002"
+#define CS2FIXES_INTERFACE_001 "CS2Fixes001"
 
 class ICS2Fixes
 {
@@ -49,4 +51,9 @@ public:
 	// iImmunity's max value is INT_MAX and will be defaulted to INT_MAX if higher
 	// Returns false if unable to modify the admin (internal admin system is not set up yet)
 	virtual bool SetAdminImmunity(std::uint64_t iSteam64ID, std::uint32_t iImmunity) = 0;
+
+	// Replaces the entities hidden from the player in slot iSlot with the nClearEntities entity indices in pClearEntities,
+	// and the players always transmitted to them (unless dead and cs2f_hide_deads is on) with bit i of iForceTransmitMask set for slot i.
+	// Does the same as the pre_transmit_entity_clear event in a single call, and stays in effect until replaced
+	virtual void SetTransmitOverrides(int iSlot, const int* pClearEntities, int nClearEntities, std::uint64_t iForceTransmitMask) = 0;
 };
\ No newline at end of file
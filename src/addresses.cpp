@@ -18,8 +18,11 @@
  */
 
 #include "addresses.h"
+#include "filesystem.h"
 #include "gameconfig.h"
+#include "schema.h"
 #include "utils/module.h"
+#include "utils/task_pool.h"
 
 #include "tier0/memdbgon.h"
 
@@ -52,6 +55,24 @@ bool addresses::Initialize(CGameConfig* g_GameConfig)
 		modules::hammer = new CModule(ROOTBIN, "tools/hammer");
 #endif
 
+	// Signature scans and vtable indexing only read the modules, so they run on worker threads while the schema is resolved here,
+	// the schema system isn't safe to use from other threads. Results are only committed on this thread once the workers are done,
+	// so everything below, the patches and the detours still resolve and report failures in the same order
+	CTaskPool pool;
+	g_GameConfig->QueueSignatureScans(pool, "addons/cs2fixes/data/signature_cache.txt");
+	pool.Add([] { modules::server->IndexVirtualTables(); });
+	pool.Add([] { modules::vphysics2->IndexVirtualTables(); });
+	pool.Start();
+
+	// The schema field accessors only read the offsets resolved here, needs modules::server to know which binary the cache is for
+	char szSchemaCachePath[MAX_PATH];
+	V_snprintf(szSchemaCachePath, sizeof(szSchemaCachePath), "%s%s", Plat_GetGameDirectory(), "/csgo/addons/cs2fixes/data/schema_cache.bin");
+	g_pFullFileSystem->CreateDirHierarchyForFile(szSchemaCachePath, nullptr);
+	schema::ResolveAllFields(szSchemaCachePath);
+
+	pool.Wait();
+	g_GameConfig->CommitSignatureScans();
+
 	RESOLVE_SIG(g_GameConfig, "SetGroundEntity", addresses::SetGroundEntity);
 	RESOLVE_SIG(g_GameConfig, "CBaseEntity::SetGravityScale", addresses::SetGravityScale);
 	RESOLVE_SIG(g_GameConfig, "CCSPlayerController_SwitchTeam", addresses::CCSPlayerController_SwitchTeam);
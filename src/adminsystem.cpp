@@ -1001,6 +1001,8 @@ CON_COMMAND_CHAT_FLAGS(health, "<name> <health> - Set a player's health", ADMFLA
 	char szAction[64];
 	V_snprintf(szAction, sizeof(szAction), "set %i health on", iHealth);
 
+	CNetworkStateChangedBatch batch;
+
 	for (int i = 0; i < iNumClients; i++)
 	{
 		CCSPlayerController* pTarget = CCSPlayerController::FromSlot(pSlots[i]);
@@ -23,13 +23,17 @@
 #include "entity/cbaseentity.h"
 #include "plat.h"
 #include "schemasystem/schemasystem.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
 
 #include "tier0/memdbgon.h"
 
 extern CGlobalVars* GetGlobals();
 
-using SchemaKeyValueMap_t = std::map<uint32_t, SchemaKey>;
-using SchemaTableMap_t = std::map<uint32_t, SchemaKeyValueMap_t>;
+static int g_iLiveClassLookups = 0;
 
 static bool IsFieldNetworked(SchemaClassFieldData_t& field)
 {
@@ -43,43 +47,67 @@ static bool IsFieldNetworked(SchemaClassFieldData_t& field)
 	return false;
 }
 
-static bool InitSchemaFieldsForClass(SchemaTableMap_t& tableMap, const char* className, uint32_t classKey)
+class CLiveSchemaProvider : public schema::ISchemaProvider
 {
-	CSchemaSystemTypeScope* pType = g_pSchemaSystem->FindTypeScopeForModule(MODULE_PREFIX "server" MODULE_EXT);
-
-	if (!pType)
-		return false;
-
-	SchemaClassInfoData_t* pClassInfo = pType->FindDeclaredClass(className).Get();
+public:
+	bool IsAvailable() override
+	{
+		return g_pSchemaSystem->FindTypeScopeForModule(MODULE_PREFIX "server" MODULE_EXT) != nullptr;
+	}
 
-	if (!pClassInfo)
+	bool GetClassFields(const char* className, std::vector<std::pair<uint32_t, SchemaKey>>& vecFields) override
 	{
-		SchemaKeyValueMap_t map;
-		tableMap.insert(std::make_pair(classKey, map));
+		CSchemaSystemTypeScope* pType = g_pSchemaSystem->FindTypeScopeForModule(MODULE_PREFIX "server" MODULE_EXT);
 
-		Warning("InitSchemaFieldsForClass(): '%s' was not found!\n", className);
-		return false;
-	}
+		if (!pType)
+			return false;
 
-	short fieldsSize = pClassInfo->m_nFieldCount;
-	SchemaClassFieldData_t* pFields = pClassInfo->m_pFields;
+		SchemaClassInfoData_t* pClassInfo = pType->FindDeclaredClass(className).Get();
 
-	SchemaKeyValueMap_t& keyValueMap = tableMap.insert(std::make_pair(classKey, SchemaKeyValueMap_t())).first->second;
+		if (!pClassInfo)
+			return false;
 
-	for (int i = 0; i < fieldsSize; ++i)
-	{
-		SchemaClassFieldData_t& field = pFields[i];
+		short fieldsSize = pClassInfo->m_nFieldCount;
+		SchemaClassFieldData_t* pFields = pClassInfo->m_pFields;
+
+		for (int i = 0; i < fieldsSize; ++i)
+		{
+			SchemaClassFieldData_t& field = pFields[i];
 
 #ifdef _DEBUG
-		Message("%s::%s found at -> 0x%X - %llx\n", className, field.m_pszName, field.m_nSingleInheritanceOffset, &field);
+			Message("%s::%s found at -> 0x%X - %llx\n", className, field.m_pszName, field.m_nSingleInheritanceOffset, &field);
 #endif
 
-		std::pair<uint32_t, SchemaKey> keyValuePair;
-		keyValuePair.first = hash_32_fnv1a_const(field.m_pszName);
-		keyValuePair.second.offset = field.m_nSingleInheritanceOffset;
-		keyValuePair.second.networked = IsFieldNetworked(field);
+			SchemaKey key;
+			key.offset = field.m_nSingleInheritanceOffset;
+			key.networked = IsFieldNetworked(field);
+
+			vecFields.push_back(std::make_pair(hash_32_fnv1a_const(field.m_pszName), key));
+		}
 
-		keyValueMap.insert(keyValuePair);
+		return true;
+	}
+
+	std::string GetBuildId() override
+	{
+		return modules::server ? modules::server->GetBuildId() : "";
+	}
+};
+
+static CLiveSchemaProvider g_liveSchemaProvider;
+static CSchemaCache g_schemaCache(&g_liveSchemaProvider);
+
+static bool InitSchemaFieldsForClass(const char* className, uint32_t classKey)
+{
+	if (!g_schemaCache.GetProvider()->IsAvailable())
+		return false;
+
+	g_iLiveClassLookups++;
+
+	if (!g_schemaCache.LookUpClass(className, classKey))
+	{
+		Warning("InitSchemaFieldsForClass(): '%s' was not found!\n", className);
+		return false;
 	}
 
 	return true;
@@ -94,45 +122,186 @@ int16_t schema::FindChainOffset(const char* className, uint32_t classNameHash)
 
 SchemaKey schema::GetOffset(const char* className, uint32_t classKey, const char* memberName, uint32_t memberKey)
 {
-	static SchemaTableMap_t schemaTableMap;
+	if (!g_schemaCache.HasClass(classKey) && !InitSchemaFieldsForClass(className, classKey))
+		return {0, 0};
+
+	const SchemaKey* pKey = g_schemaCache.FindField(classKey, memberKey);
 
-	if (!schemaTableMap.contains(classKey))
+	if (!pKey)
 	{
-		if (InitSchemaFieldsForClass(schemaTableMap, className, classKey))
-			return GetOffset(className, classKey, memberName, memberKey);
+		if (memberKey != g_ChainKey)
+			Warning("schema::GetOffset(): '%s' was not found in '%s'!\n", memberName, className);
 
 		return {0, 0};
 	}
 
-	SchemaKeyValueMap_t tableMap = schemaTableMap[classKey];
+	return *pKey;
+}
+
+// Constant initialized, so it's already null when the first field registers itself
+static schema::CSchemaField* g_pFirstSchemaField = nullptr;
+
+schema::CSchemaField::CSchemaField(const char* className, uint32_t classKey, const char* memberName, uint32_t memberKey) :
+	m_pszClassName(className), m_pszMemberName(memberName), m_iClassKey(classKey), m_iMemberKey(memberKey), m_pNext(g_pFirstSchemaField)
+{
+	g_pFirstSchemaField = this;
+}
+
+void schema::CSchemaField::Resolve()
+{
+	SchemaKey key = GetOffset(m_pszClassName, m_iClassKey, m_pszMemberName, m_iMemberKey);
+
+	offset = key.offset;
+	networked = key.networked;
+	chain = FindChainOffset(m_pszClassName, m_iClassKey);
+	m_bResolved = true;
+}
 
-	if (!tableMap.contains(memberKey))
+void schema::SetProvider(ISchemaProvider* pProvider)
+{
+	g_schemaCache.SetProvider(pProvider ? pProvider : &g_liveSchemaProvider);
+
+	for (CSchemaField* pField = g_pFirstSchemaField; pField; pField = pField->m_pNext)
+		pField->m_bResolved = false;
+}
+
+void schema::ResolveAllFields(const char* pszCachePath)
+{
+	std::string buildId = pszCachePath ? g_schemaCache.GetProvider()->GetBuildId() : "";
+	bool bUseCache = !buildId.empty() && buildId.length() < SCHEMA_CACHE_MAX_BUILD_ID;
+
+	if (bUseCache)
 	{
-		if (memberKey != g_ChainKey)
-			Warning("schema::GetOffset(): '%s' was not found in '%s'!\n", memberName, className);
+		SchemaCacheError error = g_schemaCache.Load(pszCachePath, buildId);
 
-		return {0, 0};
+		if (error == SCHEMA_CACHE_OK)
+			Message("Loaded schema cache from %s\n", pszCachePath);
+		else if (error != SCHEMA_CACHE_MISSING)
+			Message("Ignoring schema cache %s: %s\n", pszCachePath, CSchemaCache::GetErrorString(error));
+	}
+
+	g_iLiveClassLookups = 0;
+	int iCount = 0;
+
+	for (CSchemaField* pField = g_pFirstSchemaField; pField; pField = pField->m_pNext)
+	{
+		if (pField->m_bResolved)
+			continue;
+
+		pField->Resolve();
+		iCount++;
 	}
 
-	return tableMap[memberKey];
+	Message("Resolved %i schema fields, %i classes had to be looked up\n", iCount, g_iLiveClassLookups);
+
+	if (bUseCache && g_schemaCache.IsDirty() && !g_schemaCache.Save(pszCachePath, buildId))
+		Warning("Failed to save schema cache to %s\n", pszCachePath);
 }
 
+// Not batched, there's no entity handle to key these on
 void NetworkVarStateChanged(uintptr_t pNetworkVar, uint32_t nOffset, uint32 nNetworkStateChangedOffset)
 {
 	NetworkStateChangedData data(nOffset);
 	CALL_VIRTUAL(void, nNetworkStateChangedOffset, (void*)pNetworkVar, &data);
 }
 
+struct PendingNetworkStateChange_t
+{
+	CHandle<CBaseEntity> hEntity;
+	uint32 nOffset;
+	bool bChain;
+	ChangeAccessorFieldPathIndex_t pathIndex; // Only for chained members
+};
+
+#define NETWORK_STATE_BATCH_SIZE 128
+
+static int g_iNetworkStateBatchDepth = 0;
+static int g_nPendingNetworkStateChanges = 0;
+static PendingNetworkStateChange_t g_pendingNetworkStateChanges[NETWORK_STATE_BATCH_SIZE];
+
+static void FlushNetworkStateChanges()
+{
+	int nPending = g_nPendingNetworkStateChanges;
+	g_nPendingNetworkStateChanges = 0;
+
+	// Group the changes by entity, stable so each entity's fields keep the order they were written in
+	std::stable_sort(g_pendingNetworkStateChanges, g_pendingNetworkStateChanges + nPending,
+					 [](const PendingNetworkStateChange_t& a, const PendingNetworkStateChange_t& b) { return a.hEntity.ToInt() < b.hEntity.ToInt(); });
+
+	for (int iStart = 0, iEnd; iStart < nPending; iStart = iEnd)
+	{
+		CHandle<CBaseEntity> hEntity = g_pendingNetworkStateChanges[iStart].hEntity;
+
+		for (iEnd = iStart + 1; iEnd < nPending && g_pendingNetworkStateChanges[iEnd].hEntity.ToInt() == hEntity.ToInt(); iEnd++)
+			;
+
+		// Whatever ran inside the batch may have removed it
+		CBaseEntity* pEntity = hEntity.Get();
+
+		if (!pEntity)
+			continue;
+
+		for (int i = iStart; i < iEnd; i++)
+		{
+			const PendingNetworkStateChange_t& change = g_pendingNetworkStateChanges[i];
+
+			if (change.bChain)
+				pEntity->NetworkStateChanged(NetworkStateChangedData(change.nOffset, -1, change.pathIndex));
+			else
+				pEntity->NetworkStateChanged(NetworkStateChangedData(change.nOffset));
+		}
+	}
+}
+
+// Returns false if no batch is active and the change has to be sent right away
+static bool QueueNetworkStateChanged(CEntityInstance* pEntity, uint32 nOffset, bool bChain, ChangeAccessorFieldPathIndex_t pathIndex)
+{
+	if (g_iNetworkStateBatchDepth == 0)
+		return false;
+
+	CHandle<CBaseEntity> hEntity = pEntity->GetRefEHandle();
+
+	for (int i = 0; i < g_nPendingNetworkStateChanges; i++)
+	{
+		const PendingNetworkStateChange_t& change = g_pendingNetworkStateChanges[i];
+
+		if (change.hEntity.ToInt() == hEntity.ToInt() && change.nOffset == nOffset && change.bChain == bChain
+			&& (!bChain || !memcmp(&change.pathIndex, &pathIndex, sizeof(pathIndex))))
+			return true;
+	}
+
+	if (g_nPendingNetworkStateChanges == NETWORK_STATE_BATCH_SIZE)
+		FlushNetworkStateChanges();
+
+	g_pendingNetworkStateChanges[g_nPendingNetworkStateChanges++] = {hEntity, nOffset, bChain, pathIndex};
+
+	return true;
+}
+
+CNetworkStateChangedBatch::CNetworkStateChangedBatch()
+{
+	g_iNetworkStateBatchDepth++;
+}
+
+CNetworkStateChangedBatch::~CNetworkStateChangedBatch()
+{
+	if (--g_iNetworkStateBatchDepth == 0)
+		FlushNetworkStateChanges();
+}
+
 void EntityNetworkStateChanged(uintptr_t pEntity, uint nOffset)
 {
-	NetworkStateChangedData data(nOffset);
-	reinterpret_cast<CEntityInstance*>(pEntity)->NetworkStateChanged(NetworkStateChangedData(nOffset));
+	CEntityInstance* pInstance = reinterpret_cast<CEntityInstance*>(pEntity);
+
+	if (!QueueNetworkStateChanged(pInstance, nOffset, false, ChangeAccessorFieldPathIndex_t()))
+		pInstance->NetworkStateChanged(NetworkStateChangedData(nOffset));
 }
 
 void ChainNetworkStateChanged(uintptr_t pNetworkVarChainer, uint nLocalOffset)
 {
-	CEntityInstance* pEntity = reinterpret_cast<CNetworkVarChainer*>(pNetworkVarChainer)->m_pEntity;
+	CNetworkVarChainer* pChainer = reinterpret_cast<CNetworkVarChainer*>(pNetworkVarChainer);
+	CEntityInstance* pEntity = pChainer->m_pEntity;
 
-	if (pEntity)
-		pEntity->NetworkStateChanged(NetworkStateChangedData(nLocalOffset, -1, reinterpret_cast<CNetworkVarChainer*>(pNetworkVarChainer)->m_PathIndex));
+	if (pEntity && !QueueNetworkStateChanged(pEntity, nLocalOffset, true, pChainer->m_PathIndex))
+		pEntity->NetworkStateChanged(NetworkStateChangedData(nLocalOffset, -1, pChainer->m_PathIndex));
 }
@@ -24,7 +24,10 @@
 	#pragma warning(disable : 4005)
 #endif
 
+#include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #ifdef _WIN32
 	#pragma warning(pop)
@@ -37,11 +40,7 @@
 #include "virtual.h"
 #undef schema
 
-struct SchemaKey
-{
-	int32 offset;
-	bool networked;
-};
+#include "schema_cache.h"
 
 class CNetworkVarChainer
 {
@@ -58,6 +57,20 @@ private:
 	uint8 pad_0024[4];
 };
 
+// While one of these is alive, state changes from SCHEMA_FIELD sets on entities and their chained members are collected by
+// entity handle instead of sent. The outermost one sends each entity's changes once, together, when it goes out of scope,
+// and skips entities that were removed in the meantime. Without one every set is sent right away, which stays the default
+class CNetworkStateChangedBatch
+{
+public:
+	CNetworkStateChangedBatch();
+	~CNetworkStateChangedBatch();
+
+private:
+	CNetworkStateChangedBatch(const CNetworkStateChangedBatch&) = delete;
+	CNetworkStateChangedBatch& operator=(const CNetworkStateChangedBatch&) = delete;
+};
+
 void EntityNetworkStateChanged(uintptr_t pEntity, uint nOffset);
 void ChainNetworkStateChanged(uintptr_t pNetworkVarChainer, uint nOffset);
 void NetworkVarStateChanged(uintptr_t pNetworkVar, uint32_t nOffset, uint32 nNetworkStateChangedOffset);
@@ -66,22 +79,39 @@ namespace schema
 {
 	int16_t FindChainOffset(const char* className, uint32_t classNameHash);
 	SchemaKey GetOffset(const char* className, uint32_t classKey, const char* memberName, uint32_t memberKey);
-} // namespace schema
 
-constexpr uint32_t val_32_const = 0x811c9dc5;
-constexpr uint32_t prime_32_const = 0x1000193;
-constexpr uint64_t val_64_const = 0xcbf29ce484222325;
-constexpr uint64_t prime_64_const = 0x100000001b3;
+	// nullptr restores the live schema system. Forgets everything resolved so far, call ResolveAllFields again after
+	void SetProvider(ISchemaProvider* pProvider);
 
-inline constexpr uint32_t hash_32_fnv1a_const(const char* const str, const uint32_t value = val_32_const) noexcept
-{
-	return (str[0] == '\0') ? value : hash_32_fnv1a_const(&str[1], (value ^ uint32_t(str[0])) * prime_32_const);
-}
+	// Needs the schema system, call before any entity is touched.
+	// With a cache path, offsets are read from there if it was written for the same server binary and rewritten if anything was missing
+	void ResolveAllFields(const char* pszCachePath = nullptr);
 
-inline constexpr uint64_t hash_64_fnv1a_const(const char* const str, const uint64_t value = val_64_const) noexcept
-{
-	return (str[0] == '\0') ? value : hash_64_fnv1a_const(&str[1], (value ^ uint64_t(str[0])) * prime_64_const);
-}
+	// Every SCHEMA_FIELD registers one of these during static initialization, they're all resolved at once by ResolveAllFields
+	// so the accessors only have to load the offset instead of looking it up behind a static guard on first use
+	class CSchemaField
+	{
+	public:
+		CSchemaField(const char* className, uint32_t classKey, const char* memberName, uint32_t memberKey);
+
+		void Resolve();
+
+		int32 offset = 0;
+		int16_t chain = 0;
+		bool networked = false;
+
+	private:
+		friend void SetProvider(ISchemaProvider* pProvider);
+		friend void ResolveAllFields(const char* pszCachePath);
+
+		const char* m_pszClassName;
+		const char* m_pszMemberName;
+		uint32_t m_iClassKey;
+		uint32_t m_iMemberKey;
+		bool m_bResolved = false;
+		CSchemaField* m_pNext;
+	};
+} // namespace schema
 
 #define SCHEMA_FIELD_OFFSET(type, varName, extra_offset)                                                                     \
 	class varName##_prop                                                                                                     \
@@ -89,42 +119,37 @@ inline constexpr uint64_t hash_64_fnv1a_const(const char* const str, const uint6
 	public:                                                                                                                  \
 		std::add_lvalue_reference_t<type> Get()                                                                              \
 		{                                                                                                                    \
-			static const auto m_key = schema::GetOffset(m_className, m_classNameHash, #varName, m_varNameHash);              \
 			static const auto m_offset = offsetof(ThisClass, varName);														 \
 																															 \
 			uintptr_t pThisClass = ((uintptr_t)this - m_offset);                                                             \
                                                                                                                              \
-			return *reinterpret_cast<std::add_pointer_t<type>>(pThisClass + m_key.offset + extra_offset);                    \
+			return *reinterpret_cast<std::add_pointer_t<type>>(pThisClass + m_field.offset + extra_offset);                  \
 		}                                                                                                                    \
 		void Set(type& val)                                                                                                  \
 		{                                                                                                                    \
-			static const auto m_key = schema::GetOffset(m_className, m_classNameHash, #varName, m_varNameHash);              \
-			static const auto m_chain = schema::FindChainOffset(m_className, m_classNameHash);                               \
 			static const auto m_offset = offsetof(ThisClass, varName);														 \
 																															 \
 			uintptr_t pThisClass = ((uintptr_t)this - m_offset);                                                             \
                                                                                                                              \
 			NetworkStateChanged();                                                                                           \
-			*reinterpret_cast<std::add_pointer_t<type>>(pThisClass + m_key.offset + extra_offset) = val;                     \
+			*reinterpret_cast<std::add_pointer_t<type>>(pThisClass + m_field.offset + extra_offset) = val;                   \
 		}                                                                                                                    \
 		void NetworkStateChanged()                                                                                           \
 		{                                                                                                                    \
-			static const auto m_key = schema::GetOffset(m_className, m_classNameHash, #varName, m_varNameHash);				 \
-			static const auto m_chain = schema::FindChainOffset(m_className, m_classNameHash);								 \
 			static const auto m_offset = offsetof(ThisClass, varName);														 \
 																															 \
 			uintptr_t pThisClass = ((uintptr_t)this - m_offset);                                                             \
                                                                                                                              \
-			if (m_chain != 0 && m_key.networked)                                                                             \
+			if (m_field.chain != 0 && m_field.networked)                                                                     \
 			{                                                                                                                \
-				::ChainNetworkStateChanged(pThisClass + m_chain, m_key.offset + extra_offset);								 \
+				::ChainNetworkStateChanged(pThisClass + m_field.chain, m_field.offset + extra_offset);                       \
 			}                                                                                                                \
-			else if (m_key.networked)                                                                                        \
+			else if (m_field.networked)                                                                                      \
 			{                                                                                                                \
 				if (!m_networkStateChangedOffset)                                                                            \
-					::EntityNetworkStateChanged(pThisClass, m_key.offset + extra_offset);									 \
+					::EntityNetworkStateChanged(pThisClass, m_field.offset + extra_offset);                                  \
 				else                                                                                                         \
-					::NetworkVarStateChanged(pThisClass, m_key.offset + extra_offset, m_networkStateChangedOffset);			 \
+					::NetworkVarStateChanged(pThisClass, m_field.offset + extra_offset, m_networkStateChangedOffset);        \
 			}                                                                                                                \
 		}                                                                                                                    \
 		operator std::add_lvalue_reference_t<type>()                                                                         \
@@ -157,6 +182,7 @@ inline constexpr uint64_t hash_64_fnv1a_const(const char* const str, const uint6
 		/*Prevent accidentally copying this wrapper class instead of the underlying field*/                                  \
 		varName##_prop(const varName##_prop&) = delete;                                                                      \
 		static constexpr auto m_varNameHash = hash_32_fnv1a_const(#varName);                                                 \
+		static inline schema::CSchemaField m_field{m_className, m_classNameHash, #varName, m_varNameHash};                   \
 	} varName;
 
 #define SCHEMA_FIELD_POINTER_OFFSET(type, varName, extra_offset)                                                             \
@@ -165,31 +191,28 @@ inline constexpr uint64_t hash_64_fnv1a_const(const char* const str, const uint6
 	public:                                                                                                                  \
 		type* Get()                                                                                                          \
 		{                                                                                                                    \
-			static const auto m_key = schema::GetOffset(m_className, m_classNameHash, #varName, m_varNameHash);				 \
 			static const auto m_offset = offsetof(ThisClass, varName);														 \
 																															 \
 			uintptr_t pThisClass = ((uintptr_t)this - m_offset);                                                             \
                                                                                                                              \
-			return reinterpret_cast<std::add_pointer_t<type>>(pThisClass + m_key.offset + extra_offset);                     \
+			return reinterpret_cast<std::add_pointer_t<type>>(pThisClass + m_field.offset + extra_offset);                   \
 		}                                                                                                                    \
 		void NetworkStateChanged() /*Call this after editing the field*/                                                     \
 		{                                                                                                                    \
-			static const auto m_key = schema::GetOffset(m_className, m_classNameHash, #varName, m_varNameHash);				 \
-			static const auto m_chain = schema::FindChainOffset(m_className, m_classNameHash);								 \
 			static const auto m_offset = offsetof(ThisClass, varName);														 \
 																															 \
 			uintptr_t pThisClass = ((uintptr_t)this - m_offset);                                                             \
                                                                                                                              \
-			if (m_chain != 0 && m_key.networked)                                                                             \
+			if (m_field.chain != 0 && m_field.networked)                                                                     \
 			{                                                                                                                \
-				::ChainNetworkStateChanged(pThisClass + m_chain, m_key.offset + extra_offset);								 \
+				::ChainNetworkStateChanged(pThisClass + m_field.chain, m_field.offset + extra_offset);                       \
 			}                                                                                                                \
-			else if (m_key.networked)                                                                                        \
+			else if (m_field.networked)                                                                                      \
 			{                                                                                                                \
 				if (!m_networkStateChangedOffset)                                                                            \
-					::EntityNetworkStateChanged(pThisClass, m_key.offset + extra_offset);									 \
+					::EntityNetworkStateChanged(pThisClass, m_field.offset + extra_offset);                                  \
 				else                                                                                                         \
-					::NetworkVarStateChanged(pThisClass, m_key.offset + extra_offset, m_networkStateChangedOffset);			 \
+					::NetworkVarStateChanged(pThisClass, m_field.offset + extra_offset, m_networkStateChangedOffset);        \
 			}                                                                                                                \
 		}                                                                                                                    \
 		operator type*()                                                                                                     \
@@ -208,6 +231,7 @@ inline constexpr uint64_t hash_64_fnv1a_const(const char* const str, const uint6
 		/*Prevent accidentally copying this wrapper class instead of the underlying field*/                                  \
 		varName##_prop(const varName##_prop&) = delete;                                                                      \
 		static constexpr auto m_varNameHash = hash_32_fnv1a_const(#varName);                                                 \
+		static inline schema::CSchemaField m_field{m_className, m_classNameHash, #varName, m_varNameHash};                   \
 	} varName;
 
 // Use this when you want the member's value itself
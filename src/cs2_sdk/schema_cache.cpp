@@ -0,0 +1,213 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "schema_cache.h"
+#include <stdio.h>
+#include <string.h>
+
+// Cache file layout: header, then nEntries entries. Only written and read by the same build of the plugin,
+// anything that doesn't match exactly is ignored and the offsets are resolved live instead
+#define SCHEMA_CACHE_MAGIC 0x48435346 // "FSCH"
+#define SCHEMA_CACHE_VERSION 1
+#define SCHEMA_CACHE_MAX_ENTRIES (1 << 20)
+
+struct SchemaCacheHeader_t
+{
+	uint32 iMagic;
+	uint32 iVersion;
+	char szBuildId[SCHEMA_CACHE_MAX_BUILD_ID];
+	uint32 nEntries;
+	uint32 iPad;
+	uint64 iChecksum; // FNV-1a of the entries
+};
+
+struct SchemaCacheEntry_t
+{
+	uint32 iClassKey;
+	uint32 iMemberKey;
+	int32 iOffset;
+	uint8 nType;
+	uint8 bNetworked;
+	uint8 pad[2];
+};
+
+static uint64 SchemaCacheChecksum(const std::vector<SchemaCacheEntry_t>& vecEntries)
+{
+	const uint8* pData = reinterpret_cast<const uint8*>(vecEntries.data());
+	uint64 iHash = val_64_const;
+
+	for (size_t i = 0; i < vecEntries.size() * sizeof(SchemaCacheEntry_t); i++)
+		iHash = (iHash ^ pData[i]) * prime_64_const;
+
+	return iHash;
+}
+
+void CSchemaCache::SetProvider(schema::ISchemaProvider* pProvider)
+{
+	m_pProvider = pProvider;
+	m_table.Clear();
+	m_bDirty = false;
+}
+
+bool CSchemaCache::LookUpClass(const char* className, uint32_t classKey)
+{
+	std::vector<std::pair<uint32_t, SchemaKey>> vecFields;
+	bool bFound = m_pProvider->GetClassFields(className, vecFields);
+
+	m_table.AddClass(classKey, bFound);
+
+	if (!bFound)
+		return false;
+
+	for (const auto& field : vecFields)
+		m_table.AddField(classKey, field.first, field.second);
+
+	m_bDirty = true;
+
+	return true;
+}
+
+SchemaCacheError CSchemaCache::Load(const char* pszPath, const std::string& buildId)
+{
+	FILE* f = fopen(pszPath, "rb");
+
+	if (!f)
+		return SCHEMA_CACHE_MISSING;
+
+	SchemaCacheHeader_t header;
+	std::vector<SchemaCacheEntry_t> vecEntries;
+	SchemaCacheError error = SCHEMA_CACHE_OK;
+
+	if (fread(&header, sizeof(header), 1, f) != 1 || header.iMagic != SCHEMA_CACHE_MAGIC || header.iVersion != SCHEMA_CACHE_VERSION)
+		error = SCHEMA_CACHE_BAD_HEADER;
+	else if (strncmp(header.szBuildId, buildId.c_str(), sizeof(header.szBuildId)))
+		error = SCHEMA_CACHE_BUILD_CHANGED;
+	else if (header.nEntries > SCHEMA_CACHE_MAX_ENTRIES)
+		error = SCHEMA_CACHE_TOO_MANY_ENTRIES;
+	else
+	{
+		vecEntries.resize(header.nEntries);
+
+		if (fread(vecEntries.data(), sizeof(SchemaCacheEntry_t), header.nEntries, f) != header.nEntries)
+			error = SCHEMA_CACHE_TRUNCATED;
+		else if (fgetc(f) != EOF)
+			error = SCHEMA_CACHE_TRAILING_DATA;
+		else if (SchemaCacheChecksum(vecEntries) != header.iChecksum)
+			error = SCHEMA_CACHE_CHECKSUM_MISMATCH;
+	}
+
+	fclose(f);
+
+	for (size_t i = 0; error == SCHEMA_CACHE_OK && i < vecEntries.size(); i++)
+		if (vecEntries[i].nType != CSchemaTable::FIELD && vecEntries[i].nType != CSchemaTable::CLASS)
+			error = SCHEMA_CACHE_BAD_ENTRY;
+
+	if (error != SCHEMA_CACHE_OK)
+		return error;
+
+	for (const SchemaCacheEntry_t& entry : vecEntries)
+	{
+		if (entry.nType == CSchemaTable::CLASS)
+			m_table.AddClass(entry.iClassKey, true);
+		else
+			m_table.AddField(entry.iClassKey, entry.iMemberKey, {entry.iOffset, entry.bNetworked != 0});
+	}
+
+	return SCHEMA_CACHE_OK;
+}
+
+bool CSchemaCache::Save(const char* pszPath, const std::string& buildId)
+{
+	if (buildId.length() >= SCHEMA_CACHE_MAX_BUILD_ID)
+		return false;
+
+	std::vector<SchemaCacheEntry_t> vecEntries;
+
+	// Classes that weren't found aren't saved, so a class that's missing because the schema wasn't ready is retried next time
+	m_table.ForEach([&](CSchemaTable::EType nType, uint32_t classKey, uint32_t memberKey, const SchemaKey& key) {
+		SchemaCacheEntry_t entry{};
+		entry.iClassKey = classKey;
+		entry.iMemberKey = memberKey;
+		entry.iOffset = key.offset;
+		entry.nType = nType;
+		entry.bNetworked = key.networked;
+		vecEntries.push_back(entry);
+	});
+
+	SchemaCacheHeader_t header{};
+	header.iMagic = SCHEMA_CACHE_MAGIC;
+	header.iVersion = SCHEMA_CACHE_VERSION;
+	memcpy(header.szBuildId, buildId.c_str(), buildId.length());
+	header.nEntries = vecEntries.size();
+	header.iChecksum = SchemaCacheChecksum(vecEntries);
+
+	std::string tempPath = std::string(pszPath) + ".tmp";
+	FILE* f = fopen(tempPath.c_str(), "wb");
+
+	if (!f)
+		return false;
+
+	bool bWritten = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(vecEntries.data(), sizeof(SchemaCacheEntry_t), vecEntries.size(), f) == vecEntries.size();
+
+	if (fclose(f) != 0 || !bWritten)
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	// rename doesn't replace existing files on Windows
+	remove(pszPath);
+
+	if (rename(tempPath.c_str(), pszPath) != 0)
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	m_bDirty = false;
+
+	return true;
+}
+
+const char* CSchemaCache::GetErrorString(SchemaCacheError error)
+{
+	switch (error)
+	{
+		case SCHEMA_CACHE_OK:
+			return "ok";
+		case SCHEMA_CACHE_MISSING:
+			return "not found";
+		case SCHEMA_CACHE_BAD_HEADER:
+			return "bad header";
+		case SCHEMA_CACHE_BUILD_CHANGED:
+			return "server binary changed";
+		case SCHEMA_CACHE_TOO_MANY_ENTRIES:
+			return "too many entries";
+		case SCHEMA_CACHE_TRUNCATED:
+			return "truncated";
+		case SCHEMA_CACHE_TRAILING_DATA:
+			return "trailing data";
+		case SCHEMA_CACHE_CHECKSUM_MISMATCH:
+			return "checksum mismatch";
+		case SCHEMA_CACHE_BAD_ENTRY:
+			return "bad entry";
+	}
+
+	return "unknown error";
+}
@@ -0,0 +1,237 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "platform.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+// The resolved schema offsets and their disk cache on their own, without any engine types, so tests/ can check them
+// with a fake provider outside the game
+
+struct SchemaKey
+{
+	int32 offset;
+	bool networked;
+};
+
+namespace schema
+{
+	// Where class fields are resolved from, the live schema system unless replaced, e.g. by a fake for testing
+	class ISchemaProvider
+	{
+	public:
+		// False while the schema can't be queried yet, classes aren't marked as missing then
+		virtual bool IsAvailable() = 0;
+
+		// Appends (field name hash, key) for every field of className, false if the class doesn't exist
+		virtual bool GetClassFields(const char* className, std::vector<std::pair<uint32_t, SchemaKey>>& vecFields) = 0;
+
+		// Identifies the server binary the fields come from, the disk cache is skipped when this is empty
+		virtual std::string GetBuildId() = 0;
+	};
+} // namespace schema
+
+constexpr uint32_t val_32_const = 0x811c9dc5;
+constexpr uint32_t prime_32_const = 0x1000193;
+constexpr uint64_t val_64_const = 0xcbf29ce484222325;
+constexpr uint64_t prime_64_const = 0x100000001b3;
+
+inline constexpr uint32_t hash_32_fnv1a_const(const char* const str, const uint32_t value = val_32_const) noexcept
+{
+	return (str[0] == '\0') ? value : hash_32_fnv1a_const(&str[1], (value ^ uint32_t(str[0])) * prime_32_const);
+}
+
+inline constexpr uint64_t hash_64_fnv1a_const(const char* const str, const uint64_t value = val_64_const) noexcept
+{
+	return (str[0] == '\0') ? value : hash_64_fnv1a_const(&str[1], (value ^ uint64_t(str[0])) * prime_64_const);
+}
+
+// Every resolved field of every looked up class in one open addressing table keyed by (class hash, field hash),
+// plus one marker entry per class so classes without the requested field aren't queried again
+class CSchemaTable
+{
+public:
+	enum EType : uint8
+	{
+		EMPTY,
+		FIELD,
+		CLASS,
+	};
+
+	const SchemaKey* FindField(uint32_t classKey, uint32_t memberKey) const { return Find(MakeKey(classKey, memberKey), FIELD); }
+	bool HasClass(uint32_t classKey) const { return Find(classKey, CLASS); }
+
+	void AddField(uint32_t classKey, uint32_t memberKey, SchemaKey key) { Insert(MakeKey(classKey, memberKey), FIELD, key, true); }
+	void AddClass(uint32_t classKey, bool bFound) { Insert(classKey, CLASS, {0, 0}, bFound); }
+
+	void Clear()
+	{
+		m_vecEntries.clear();
+		m_nCount = 0;
+	}
+
+	// Calls func(nType, classKey, memberKey, key) for every field and every class that was found
+	template <typename F>
+	void ForEach(F&& func) const
+	{
+		for (const Entry_t& entry : m_vecEntries)
+		{
+			if (entry.nType == FIELD)
+				func(FIELD, (uint32_t)(entry.iKey >> 32), (uint32_t)entry.iKey, entry.value);
+			else if (entry.nType == CLASS && entry.bFound)
+				func(CLASS, (uint32_t)entry.iKey, 0u, entry.value);
+		}
+	}
+
+private:
+	struct Entry_t
+	{
+		uint64 iKey;
+		SchemaKey value;
+		EType nType;
+		bool bFound; // Whether the schema system knew this class, only used by CLASS entries
+	};
+
+	static uint64 MakeKey(uint32_t classKey, uint32_t memberKey) { return ((uint64)classKey << 32) | memberKey; }
+
+	static uint32 Hash(uint64 iKey, EType nType)
+	{
+		iKey ^= nType;
+		iKey ^= iKey >> 33;
+		iKey *= 0xff51afd7ed558ccdull;
+		iKey ^= iKey >> 33;
+		return (uint32)iKey;
+	}
+
+	const SchemaKey* Find(uint64 iKey, EType nType) const
+	{
+		if (m_vecEntries.empty())
+			return nullptr;
+
+		uint32 iMask = m_vecEntries.size() - 1;
+
+		for (uint32 i = Hash(iKey, nType) & iMask;; i = (i + 1) & iMask)
+		{
+			const Entry_t& entry = m_vecEntries[i];
+
+			if (entry.nType == EMPTY)
+				return nullptr;
+
+			if (entry.iKey == iKey && entry.nType == nType)
+				return &entry.value;
+		}
+	}
+
+	void Insert(uint64 iKey, EType nType, SchemaKey value, bool bFound)
+	{
+		// Stay at most half full so probe sequences stay short
+		if ((m_nCount + 1) * 2 > m_vecEntries.size())
+			Grow();
+
+		uint32 iMask = m_vecEntries.size() - 1;
+
+		for (uint32 i = Hash(iKey, nType) & iMask;; i = (i + 1) & iMask)
+		{
+			Entry_t& entry = m_vecEntries[i];
+
+			if (entry.nType == EMPTY)
+			{
+				entry = {iKey, value, nType, bFound};
+				m_nCount++;
+				return;
+			}
+
+			if (entry.iKey == iKey && entry.nType == nType)
+			{
+				entry.value = value;
+				entry.bFound = bFound;
+				return;
+			}
+		}
+	}
+
+	void Grow()
+	{
+		std::vector<Entry_t> vecOld = std::move(m_vecEntries);
+		m_vecEntries.assign(vecOld.empty() ? 4096 : vecOld.size() * 2, Entry_t{});
+		m_nCount = 0;
+
+		for (const Entry_t& entry : vecOld)
+			if (entry.nType != EMPTY)
+				Insert(entry.iKey, entry.nType, entry.value, entry.bFound);
+	}
+
+	std::vector<Entry_t> m_vecEntries;
+	size_t m_nCount = 0;
+};
+
+#define SCHEMA_CACHE_MAX_BUILD_ID 128
+
+enum SchemaCacheError
+{
+	SCHEMA_CACHE_OK,
+	SCHEMA_CACHE_MISSING,
+	SCHEMA_CACHE_BAD_HEADER,
+	SCHEMA_CACHE_BUILD_CHANGED,
+	SCHEMA_CACHE_TOO_MANY_ENTRIES,
+	SCHEMA_CACHE_TRUNCATED,
+	SCHEMA_CACHE_TRAILING_DATA,
+	SCHEMA_CACHE_CHECKSUM_MISMATCH,
+	SCHEMA_CACHE_BAD_ENTRY,
+};
+
+// Fields are looked up through the provider one class at a time, and the table can be saved to and loaded from a file
+// that's only valid for the server build it was written for
+class CSchemaCache
+{
+public:
+	CSchemaCache(schema::ISchemaProvider* pProvider) :
+		m_pProvider(pProvider) {}
+
+	schema::ISchemaProvider* GetProvider() const { return m_pProvider; }
+
+	// Forgets everything, nothing resolved so far came from the new provider
+	void SetProvider(schema::ISchemaProvider* pProvider);
+
+	bool HasClass(uint32_t classKey) const { return m_table.HasClass(classKey); }
+	const SchemaKey* FindField(uint32_t classKey, uint32_t memberKey) const { return m_table.FindField(classKey, memberKey); }
+
+	// Adds every field of the class from the provider, false if it doesn't know the class. Classes it doesn't know
+	// are remembered so they aren't asked for again, so only call this while the provider is available
+	bool LookUpClass(const char* className, uint32_t classKey);
+
+	// Whether a class had to be looked up since the last load or save, so the file is missing something
+	bool IsDirty() const { return m_bDirty; }
+
+	// Adds the file's entries to the table if it was written for buildId, which has to be shorter than SCHEMA_CACHE_MAX_BUILD_ID
+	SchemaCacheError Load(const char* pszPath, const std::string& buildId);
+
+	// Written to a temporary file first so a crash can't leave a half written cache behind
+	bool Save(const char* pszPath, const std::string& buildId);
+
+	static const char* GetErrorString(SchemaCacheError error);
+
+private:
+	schema::ISchemaProvider* m_pProvider;
+	CSchemaTable m_table;
+	bool m_bDirty = false;
+};
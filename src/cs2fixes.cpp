@@ -57,6 +57,7 @@
 #include "te.pb.h"
 #include "tier0/dbg.h"
 #include "tier0/vprof.h"
+#include "transmit.h"
 #include "user_preferences.h"
 #include "usermessages.pb.h"
 #include "votemanager.h"
@@ -1009,30 +1010,8 @@ void CS2Fixes::Hook_GameFramePost(bool simulating, bool bFirstTick, bool bLastTi
 	g_flLastTickedTime = GetGlobals()->curtime;
 	g_bHasTicked = true;
 
-	for (int i = g_timers.Tail(); i != g_timers.InvalidIndex();)
-	{
-		auto timer = g_timers[i];
-
-		int prevIndex = i;
-		i = g_timers.Previous(i);
-
-		if (timer->m_flLastExecute == -1)
-			timer->m_flLastExecute = g_flUniversalTime;
-
-		// Timer execute
-		if (timer->m_flLastExecute + timer->m_flInterval <= g_flUniversalTime)
-		{
-			if ((!timer->m_bPreserveRoundChange && timer->m_iRoundNum != g_iRoundNum) || !timer->Execute())
-			{
-				delete timer;
-				g_timers.Remove(prevIndex);
-			}
-			else
-			{
-				timer->m_flLastExecute = g_flUniversalTime;
-			}
-		}
-	}
+	RunDeferredActions();
+	RunTimers();
 
 	if (g_cvarEnableZR.Get())
 		CZRRegenTimer::Tick();
@@ -1040,36 +1019,6 @@ void CS2Fixes::Hook_GameFramePost(bool simulating, bool bFirstTick, bool bLastTi
 	EntityHandler_OnGameFramePost(simulating, GetGlobals()->tickcount);
 }
 
-extern CConVar<bool> g_cvarFlashLightTransmitOthers;
-extern CConVar<bool> g_cvarEnableHideDeadPlayer;
-
-int evClearTransmit[64][1024]; // 和 c# 搭配的 transmit 互通接口
-bool evAddTransmit[64][64];
-
-GAME_EVENT_F2(choppers_incoming_warning, pre_transmit_entity_clear)
-{
-	auto customEventName = pEvent->GetString("custom_event", "");
-	if (strcmp(customEventName, "pre_transmit_entity_clear") != 0)
-		return;
-	int slot = pEvent->GetInt("player_index", -1);
-	if (slot < 1 || slot > 64) return;
-	slot = slot - 1;
-	for (int i = 0; i < 1024; i++)
-	{
-		char name[32];
-		V_snprintf(name, sizeof(name), "clear%d", i);
-		int index = pEvent->GetInt(name);
-		evClearTransmit[slot][i] = index;
-	}
-	for (int i = 0; i < 64; i++)
-	{
-		char name[32];
-		V_snprintf(name, sizeof(name), "add%d", i);
-		bool forceAdd = pEvent->GetBool(name, false);
-		evAddTransmit[slot][i] = forceAdd;
-	}
-}
-
 void CS2Fixes::Hook_CheckTransmit(CCheckTransmitInfo** ppInfoList, int infoCount, CBitVec<16384>& unionTransmitEdicts,
 								  CBitVec<16384>&, const Entity2Networkable_t** pNetworkables, const uint16* pEntityIndicies, int nEntities)
 {
@@ -1078,6 +1027,8 @@ void CS2Fixes::Hook_CheckTransmit(CCheckTransmitInfo** ppInfoList, int infoCount
 
 	VPROF("CS2Fixes::Hook_CheckTransmit");
 
+	Transmit_Update();
+
 	for (int i = 0; i < infoCount; i++)
 	{
 		auto& pInfo = ppInfoList[i];
@@ -1087,93 +1038,7 @@ void CS2Fixes::Hook_CheckTransmit(CCheckTransmitInfo** ppInfoList, int infoCount
 		static int offset = g_GameConfig->GetOffset("CheckTransmitPlayerSlot");
 		int iPlayerSlot = (int)*((uint8*)pInfo + offset);
 
-		CCSPlayerController* pSelfController = CCSPlayerController::FromSlot(iPlayerSlot);
-
-		if (!pSelfController || !pSelfController->IsConnected())
-			continue;
-
-		auto pSelfZEPlayer = g_playerManager->GetPlayer(iPlayerSlot);
-
-		if (!pSelfZEPlayer)
-			continue;
-
-		for (int j = 0; j < 1024; j++)
-		{
-			int entIndex = evClearTransmit[iPlayerSlot][j];
-			if (entIndex > 0)
-				pInfo->m_pTransmitEntity->Clear(entIndex);
-		}
-		bool hideDead = g_cvarEnableHideDeadPlayer.GetBool();
-		for (int j = 0; j < GetGlobals()->maxClients; j++)
-		{
-			CCSPlayerController* pController = CCSPlayerController::FromSlot(j);
-			// Always transmit to themselves
-			if (!pController || pController->m_bIsHLTV || j == iPlayerSlot)
-				continue;
-
-			// Don't transmit other players' flashlights
-			CBarnLight* pFlashLight = pController->IsConnected() ? g_playerManager->GetPlayer(j)->GetFlashLight() : nullptr;
-
-			if (!g_cvarFlashLightTransmitOthers.Get() && pFlashLight)
-				pInfo->m_pTransmitEntity->Clear(pFlashLight->entindex());
-
-			if (g_cvarEnableEntWatch.Get() && g_pEWHandler->IsConfigLoaded())
-			{
-				// Don't transmit other players' entwatch hud
-				CPointWorldText* pHud = pController->IsConnected() ? g_playerManager->GetPlayer(j)->GetEntwatchHud() : nullptr;
-				if (pHud)
-					pInfo->m_pTransmitEntity->Clear(pHud->entindex());
-			}
-
-			// Always transmit other players if spectating
-			if (!g_cvarEnableHide.Get() || pSelfController->GetPawnState() == STATE_OBSERVER_MODE)
-				continue;
-
-			// Get the actual pawn as the player could be currently spectating
-			CCSPlayerPawn* pPawn = pController->GetPlayerPawn();
-
-			if (!pPawn)
-				continue;
-
-			if (pSelfZEPlayer->HoldingRMB)  // 如果按着鼠标右键就不 hide 队友
-				continue;
-
-			// Hide players marked as hidden or ANY dead player, it seems that a ragdoll of a previously hidden player can crash?
-			// TODO: Revert this if/when valve fixes the issue?
-			// Also do not hide leaders to other players
-			ZEPlayer *pOtherZEPlayer = g_playerManager->GetPlayer(j);
-			bool shouldHide = false;
-			if (!pPawn->IsAlive())
-			{
-				if (hideDead)
-				{
-					shouldHide = true; // 死亡的玩家一定不传输
-				}
-			}
-			else if (evAddTransmit[iPlayerSlot][j])
-			{
-				shouldHide = false; // 白名单里要求的进行传输
-			}
-			else if ((pSelfZEPlayer->ShouldBlockTransmit(j)))
-			{
-				shouldHide = true; // 没有要求的玩家按距离控制管理
-				if (pOtherZEPlayer)
-				{
-					if (pOtherZEPlayer->IsLeader())
-						shouldHide = false; // 指挥官不隐藏
-					else if (pOtherZEPlayer->GetBeaconParticle())
-						shouldHide = false; // 有beacon的不隐藏
-				}
-			}
-			if (shouldHide)
-				pInfo->m_pTransmitEntity->Clear(pPawn->entindex());
-		}
-
-		// Don't transmit glow model to it's owner
-		CBaseModelEntity* pGlowModel = pSelfZEPlayer->GetGlowModel();
-
-		if (pGlowModel)
-			pInfo->m_pTransmitEntity->Clear(pGlowModel->entindex());
+		Transmit_Apply(iPlayerSlot, *pInfo->m_pTransmitEntity);
 	}
 }
 
@@ -1357,7 +1222,8 @@ void CS2Fixes::Hook_SetGameSpawnGroupMgr(IGameSpawnGroupMgr* pSpawnGroupMgr)
 
 void* CS2Fixes::OnMetamodQuery(const char* iface, int* ret)
 {
-	if (V_strcmp(iface, CS2FIXES_INTERFACE))
+	// 001 is the same vtable without SetTransmitOverrides
+	if (V_strcmp(iface, CS2FIXES_INTERFACE) && V_strcmp(iface, CS2FIXES_INTERFACE_001))
 	{
 		if (ret)
 			*ret = META_IFACE_FAILED;
@@ -1415,6 +1281,11 @@ bool CS2Fixes::SetAdminImmunity(std::uint64_t iSteam64ID, std::uint32_t iImmunit
 	return true;
 }
 
+void CS2Fixes::SetTransmitOverrides(int iSlot, const int* pClearEntities, int nClearEntities, std::uint64_t iForceTransmitMask)
+{
+	Transmit_SetOverrides(iSlot, pClearEntities, nClearEntities, static_cast<uint64>(iForceTransmitMask));
+}
+
 void CS2Fixes::OnLevelInit(char const* pMapName,
 						   char const* pMapEntities,
 						   char const* pOldLevel,
@@ -1453,6 +1324,8 @@ void CS2Fixes::OnLevelShutdown()
 {
 	Message("OnLevelShutdown()\n");
 
+	Transmit_Invalidate();
+
 	if (g_cvarVoteManagerEnable.Get())
 		g_pMapVoteSystem->OnLevelShutdown();
 }
@@ -101,6 +101,7 @@ public: // MetaMod API
 	bool SetAdminFlags(std::uint64_t iSteam64ID, std::uint64_t iFlags) override;
 	int GetAdminImmunity(std::uint64_t iSteam64ID) const override;
 	bool SetAdminImmunity(std::uint64_t iSteam64ID, std::uint32_t iImmunity) override;
+	void SetTransmitOverrides(int iSlot, const int* pClearEntities, int nClearEntities, std::uint64_t iForceTransmitMask) override;
 
 public:
 	const char* GetAuthor() { return PLUGIN_AUTHOR; }
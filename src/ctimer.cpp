@@ -18,25 +18,653 @@
  */
 
 #include "ctimer.h"
+#include "common.h"
+#include "convar.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
 
-CUtlLinkedList<CTimerBase*> g_timers;
+extern double g_flUniversalTime;
 
-void RemoveTimers()
+TimerAllocStats_t g_timerAllocStats;
+
+CConVar<bool> g_cvarTimerProfile("cs2f_timer_profile", FCVAR_NONE, "Whether to record execution times of timers per creation site, see cs2f_timer_profile_dump", false);
+
+struct TimerSiteStats_t
+{
+	std::source_location location;
+	uint64 iCalls;
+	double flTotalTime;
+	double flMaxTime;
+};
+
+struct TimerSiteHash
+{
+	size_t operator()(const std::pair<const char*, uint32>& site) const { return std::hash<const char*>()(site.first) ^ ((size_t)site.second << 1); }
+};
+
+// Keyed by file name pointer and line, every call site has its own string literal for the file name
+static std::unordered_map<std::pair<const char*, uint32>, TimerSiteStats_t, TimerSiteHash> g_mapTimerSiteStats;
+
+static void RecordTimerExecution(const std::source_location& location, double flTime)
 {
-	g_timers.PurgeAndDeleteElements();
+	TimerSiteStats_t& stats = g_mapTimerSiteStats[{location.file_name(), location.line()}];
+
+	stats.location = location;
+	stats.iCalls++;
+	stats.flTotalTime += flTime;
+	stats.flMaxTime = std::max(stats.flMaxTime, flTime);
 }
 
-void RemoveMapTimers()
+// Timers per slab, a busy map keeps a few hundred alive so this usually means one or two slabs for the whole session
+#define TIMER_POOL_SLAB_BITS 8
+#define TIMER_POOL_SLAB_SIZE (1 << TIMER_POOL_SLAB_BITS)
+#define TIMER_POOL_SLAB_MASK (TIMER_POOL_SLAB_SIZE - 1)
+
+// Fixed size block allocator for CTimer, slabs are kept around until unload so spawn storms only grow it once
+// Every block starts with a small header holding its index and a serial that is bumped on free, which is what CTimerHandle is checked against
+class CTimerPool
+{
+public:
+	~CTimerPool();
+
+	void* Alloc();
+	void Free(void* pMem);
+	CTimerHandle GetHandle(const CTimer* pTimer) const;
+	CTimer* Get(CTimerHandle hTimer) const;
+
+private:
+	struct alignas(std::max_align_t) BlockHeader_t
+	{
+		uint32 iIndex;
+		uint32 iSerial;
+		bool bInUse;
+	};
+
+	struct FreeBlock_t
+	{
+		FreeBlock_t* pNext;
+	};
+
+	static constexpr size_t BLOCK_SIZE = sizeof(BlockHeader_t) + sizeof(CTimer);
+
+	static BlockHeader_t* GetHeader(const void* pMem) { return (BlockHeader_t*)((unsigned char*)pMem - sizeof(BlockHeader_t)); }
+	BlockHeader_t* GetHeader(uint32 iIndex) const { return (BlockHeader_t*)(m_vecSlabs[iIndex >> TIMER_POOL_SLAB_BITS] + BLOCK_SIZE * (iIndex & TIMER_POOL_SLAB_MASK)); }
+
+	std::vector<unsigned char*> m_vecSlabs;
+	FreeBlock_t* m_pFreeList = nullptr;
+};
+
+CTimerPool g_timerPool;
+
+CTimerPool::~CTimerPool()
+{
+	for (unsigned char* pSlab : m_vecSlabs)
+		delete[] pSlab;
+}
+
+void* CTimerPool::Alloc()
+{
+	if (!m_pFreeList)
+	{
+		unsigned char* pSlab = new unsigned char[BLOCK_SIZE * TIMER_POOL_SLAB_SIZE];
+		uint32 iFirstIndex = (uint32)m_vecSlabs.size() << TIMER_POOL_SLAB_BITS;
+
+		m_vecSlabs.push_back(pSlab);
+		g_timerAllocStats.iSlabAllocs++;
+
+		for (int i = TIMER_POOL_SLAB_SIZE - 1; i >= 0; i--)
+		{
+			BlockHeader_t* pHeader = new (pSlab + BLOCK_SIZE * i) BlockHeader_t{iFirstIndex + i, 0, false};
+			FreeBlock_t* pBlock = reinterpret_cast<FreeBlock_t*>(pHeader + 1);
+			pBlock->pNext = m_pFreeList;
+			m_pFreeList = pBlock;
+		}
+	}
+
+	FreeBlock_t* pBlock = m_pFreeList;
+	m_pFreeList = pBlock->pNext;
+	GetHeader(pBlock)->bInUse = true;
+	g_timerAllocStats.iTimerAllocs++;
+
+	return pBlock;
+}
+
+void CTimerPool::Free(void* pMem)
+{
+	BlockHeader_t* pHeader = GetHeader(pMem);
+	pHeader->iSerial++;
+	pHeader->bInUse = false;
+
+	FreeBlock_t* pBlock = static_cast<FreeBlock_t*>(pMem);
+	pBlock->pNext = m_pFreeList;
+	m_pFreeList = pBlock;
+	g_timerAllocStats.iTimerFrees++;
+}
+
+CTimerHandle CTimerPool::GetHandle(const CTimer* pTimer) const
+{
+	BlockHeader_t* pHeader = GetHeader(pTimer);
+
+	return {pHeader->iIndex, pHeader->iSerial};
+}
+
+CTimer* CTimerPool::Get(CTimerHandle hTimer) const
+{
+	if ((hTimer.m_iIndex >> TIMER_POOL_SLAB_BITS) >= m_vecSlabs.size())
+		return nullptr;
+
+	BlockHeader_t* pHeader = GetHeader(hTimer.m_iIndex);
+
+	if (!pHeader->bInUse || pHeader->iSerial != hTimer.m_iSerial)
+		return nullptr;
+
+	return reinterpret_cast<CTimer*>(pHeader + 1);
+}
+
+void* CTimer::operator new(size_t size)
+{
+	return g_timerPool.Alloc();
+}
+
+void CTimer::operator delete(void* pMem)
+{
+	g_timerPool.Free(pMem);
+}
+
+CTimerHandle CTimer::GetHandle() const
+{
+	return g_timerPool.GetHandle(this);
+}
+
+// One wheel slot per server tick, anything due within the same tick lands in the same slot
+#define TIMER_WHEEL_RESOLUTION (1.0 / 64.0)
+
+// The root level has 256 one-tick slots (4 seconds), every upper level has 64 slots each spanning a full lower level,
+// so the 3 upper levels cover ~4 minutes, ~4.5 hours and ~12 days respectively
+#define TIMER_WHEEL_ROOT_BITS 8
+#define TIMER_WHEEL_ROOT_SIZE (1 << TIMER_WHEEL_ROOT_BITS)
+#define TIMER_WHEEL_ROOT_MASK (TIMER_WHEEL_ROOT_SIZE - 1)
+#define TIMER_WHEEL_LEVEL_BITS 6
+#define TIMER_WHEEL_LEVEL_SIZE (1 << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_LEVEL_MASK (TIMER_WHEEL_LEVEL_SIZE - 1)
+#define TIMER_WHEEL_LEVELS 3
+
+// Hierarchical timing wheel, timers only ever get looked at when their slot comes up (or cascades down a level)
+// instead of every timer being checked on every frame
+class CTimerWheel
+{
+public:
+	void Add(CTimerBase* pTimer);
+	void Run(double flTime);
+	void Remove(CTimerBase* pTimer);
+	void Cancel(CTimerBase* pTimer);
+	void Reschedule(CTimerBase* pTimer, float flInterval, double flTime);
+	float GetTimeLeft(CTimerBase* pTimer, double flTime) const;
+
+	// Calls func on every timer owned by the wheel, func is allowed to Remove the timer it was given
+	template <typename F>
+	void ForEach(F func);
+
+private:
+	void Schedule(CTimerBase* pTimer);
+	void Cascade(int iLevel);
+	int LevelShift(int iLevel) const { return TIMER_WHEEL_ROOT_BITS + iLevel * TIMER_WHEEL_LEVEL_BITS; }
+
+	static int64_t TimeToTick(double flTime) { return (int64_t)std::floor(flTime / TIMER_WHEEL_RESOLUTION); }
+	static void Link(CTimerBase** ppList, CTimerBase* pTimer);
+	static void Unlink(CTimerBase* pTimer);
+
+	// Timers created since the last run, these only get their first execution time once the next frame comes around
+	CTimerBase* m_pPending = nullptr;
+	// Timers that are being worked on during Run, kept as proper lists so any timer can still be removed at any point
+	CTimerBase* m_pHeld = nullptr;
+	CTimerBase* m_pRunning = nullptr;
+	CTimerBase* m_pFired = nullptr;
+
+	CTimerBase* m_pRoot[TIMER_WHEEL_ROOT_SIZE] = {};
+	CTimerBase* m_pLevels[TIMER_WHEEL_LEVELS][TIMER_WHEEL_LEVEL_SIZE] = {};
+
+	// The timer whose function is running right now, it is in no list at that point
+	CTimerBase* m_pExecuting = nullptr;
+	bool m_bExecutingCancelled = false;
+
+	int64_t m_iCurrentTick = 0;
+	int m_iScheduled = 0;
+};
+
+CTimerWheel g_timerWheel;
+
+void CTimerWheel::Link(CTimerBase** ppList, CTimerBase* pTimer)
+{
+	pTimer->m_ppWheelList = ppList;
+	pTimer->m_pWheelPrev = nullptr;
+	pTimer->m_pWheelNext = *ppList;
+
+	if (*ppList)
+		(*ppList)->m_pWheelPrev = pTimer;
+
+	*ppList = pTimer;
+}
+
+void CTimerWheel::Unlink(CTimerBase* pTimer)
+{
+	if (!pTimer->m_ppWheelList)
+		return;
+
+	if (pTimer->m_pWheelPrev)
+		pTimer->m_pWheelPrev->m_pWheelNext = pTimer->m_pWheelNext;
+	else
+		*pTimer->m_ppWheelList = pTimer->m_pWheelNext;
+
+	if (pTimer->m_pWheelNext)
+		pTimer->m_pWheelNext->m_pWheelPrev = pTimer->m_pWheelPrev;
+
+	pTimer->m_ppWheelList = nullptr;
+	pTimer->m_pWheelPrev = nullptr;
+	pTimer->m_pWheelNext = nullptr;
+}
+
+void CTimerWheel::Add(CTimerBase* pTimer)
+{
+	Link(&m_pPending, pTimer);
+}
+
+void CTimerWheel::Remove(CTimerBase* pTimer)
+{
+	CTimerBase** ppList = pTimer->m_ppWheelList;
+
+	if (ppList && ppList != &m_pPending && ppList != &m_pHeld && ppList != &m_pRunning && ppList != &m_pFired)
+		m_iScheduled--;
+
+	Unlink(pTimer);
+}
+
+void CTimerWheel::Cancel(CTimerBase* pTimer)
+{
+	// Can't delete a timer from under its own function, let Run clean it up once it returns
+	if (pTimer == m_pExecuting)
+	{
+		m_bExecutingCancelled = true;
+		return;
+	}
+
+	Remove(pTimer);
+	delete pTimer;
+}
+
+void CTimerWheel::Reschedule(CTimerBase* pTimer, float flInterval, double flTime)
+{
+	pTimer->m_flInterval = flInterval;
+
+	// Pending timers get their execution time on the next run anyway, and the executing one is rescheduled by its return value
+	if (pTimer == m_pExecuting || pTimer->m_ppWheelList == &m_pPending)
+		return;
+
+	Remove(pTimer);
+	pTimer->m_flNextExecute = flTime + flInterval;
+	Schedule(pTimer);
+}
+
+float CTimerWheel::GetTimeLeft(CTimerBase* pTimer, double flTime) const
+{
+	if (pTimer == m_pExecuting)
+		return 0.0f;
+
+	if (pTimer->m_ppWheelList == &m_pPending)
+		return pTimer->m_flInterval;
+
+	return std::max((float)(pTimer->m_flNextExecute - flTime), 0.0f);
+}
+
+void CTimerWheel::Schedule(CTimerBase* pTimer)
+{
+	int64_t iTick = TimeToTick(pTimer->m_flNextExecute);
+
+	// Overdue timers go in the current slot, which gets looked at again on every run until the tick is over
+	if (iTick < m_iCurrentTick)
+		iTick = m_iCurrentTick;
+
+	int64_t iDelta = iTick - m_iCurrentTick;
+
+	m_iScheduled++;
+
+	if (iDelta < TIMER_WHEEL_ROOT_SIZE)
+	{
+		Link(&m_pRoot[iTick & TIMER_WHEEL_ROOT_MASK], pTimer);
+		return;
+	}
+
+	for (int i = 0; i < TIMER_WHEEL_LEVELS; i++)
+	{
+		int iShift = LevelShift(i + 1);
+
+		if (iDelta < ((int64_t)1 << iShift) || i == TIMER_WHEEL_LEVELS - 1)
+		{
+			// Anything beyond the last level is parked in its furthest slot and gets rescheduled when that cascades
+			if (iDelta >= ((int64_t)1 << iShift))
+				iTick = m_iCurrentTick + ((int64_t)1 << iShift) - 1;
+
+			Link(&m_pLevels[i][(iTick >> LevelShift(i)) & TIMER_WHEEL_LEVEL_MASK], pTimer);
+			return;
+		}
+	}
+}
+
+// Move every timer of the upper level slot that m_iCurrentTick just entered down to where it belongs now
+void CTimerWheel::Cascade(int iLevel)
+{
+	CTimerBase** ppSlot = &m_pLevels[iLevel][(m_iCurrentTick >> LevelShift(iLevel)) & TIMER_WHEEL_LEVEL_MASK];
+
+	while (*ppSlot)
+	{
+		CTimerBase* pTimer = *ppSlot;
+
+		Unlink(pTimer);
+		m_iScheduled--;
+		Schedule(pTimer);
+	}
+}
+
+void CTimerWheel::Run(double flTime)
 {
-	for (int i = g_timers.Tail(); i != g_timers.InvalidIndex();)
+	int64_t iTick = TimeToTick(flTime);
+
+	// Nothing can fire in between, so there is no need to walk every tick since the last run
+	if (m_iScheduled == 0 && iTick > m_iCurrentTick)
+		m_iCurrentTick = iTick;
+
+	while (m_pPending)
+	{
+		CTimerBase* pTimer = m_pPending;
+		Unlink(pTimer);
+
+		if (pTimer->m_flLastExecute == -1)
+			pTimer->m_flLastExecute = flTime;
+
+		pTimer->m_flNextExecute = pTimer->m_flLastExecute + pTimer->m_flInterval;
+		Schedule(pTimer);
+	}
+
+	// The current tick is revisited on every run, as its slot can hold timers due later within the same tick
+	for (int64_t i = m_iCurrentTick; i <= iTick; i++)
 	{
-		int prevIndex = i;
-		i = g_timers.Previous(i);
+		if (i != m_iCurrentTick)
+		{
+			m_iCurrentTick = i;
 
-		if (g_timers[prevIndex]->m_bPreserveMapChange)
+			for (int iLevel = TIMER_WHEEL_LEVELS - 1; iLevel >= 0; iLevel--)
+			{
+				if ((i & (((int64_t)1 << LevelShift(iLevel)) - 1)) == 0)
+					Cascade(iLevel);
+			}
+		}
+
+		CTimerBase** ppSlot = &m_pRoot[i & TIMER_WHEEL_ROOT_MASK];
+
+		while (*ppSlot)
+		{
+			CTimerBase* pTimer = *ppSlot;
+			Unlink(pTimer);
+
+			if (pTimer->m_flNextExecute > flTime)
+			{
+				Link(&m_pHeld, pTimer);
+				continue;
+			}
+
+			m_iScheduled--;
+			Link(&m_pRunning, pTimer);
+		}
+
+		// Not due yet, but still within this tick
+		while (m_pHeld)
+		{
+			CTimerBase* pTimer = m_pHeld;
+			Unlink(pTimer);
+			Link(ppSlot, pTimer);
+		}
+	}
+
+	// Execute in a second pass so callbacks always see a consistent wheel
+	bool bProfile = g_cvarTimerProfile.Get();
+
+	while (m_pRunning)
+	{
+		CTimerBase* pTimer = m_pRunning;
+		Unlink(pTimer);
+
+		if (!pTimer->m_bPreserveRoundChange && pTimer->m_iRoundNum != g_iRoundNum)
+		{
+			delete pTimer;
 			continue;
+		}
+
+		m_pExecuting = pTimer;
+		m_bExecutingCancelled = false;
+
+		bool bContinue;
 
-		delete g_timers[prevIndex];
-		g_timers.Remove(prevIndex);
+		if (bProfile) [[unlikely]]
+		{
+			auto start = std::chrono::steady_clock::now();
+			bContinue = pTimer->Execute();
+			RecordTimerExecution(pTimer->m_location, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+		else
+		{
+			bContinue = pTimer->Execute();
+		}
+
+		m_pExecuting = nullptr;
+
+		if (!bContinue || m_bExecutingCancelled)
+		{
+			delete pTimer;
+			continue;
+		}
+
+		pTimer->m_flLastExecute = flTime;
+		pTimer->m_flNextExecute = flTime + pTimer->m_flInterval;
+		Link(&m_pFired, pTimer);
+	}
+
+	// Rescheduling only after everything ran makes sure a 0 interval timer runs once per frame, not forever
+	while (m_pFired)
+	{
+		CTimerBase* pTimer = m_pFired;
+		Unlink(pTimer);
+		Schedule(pTimer);
 	}
+}
+
+template <typename F>
+void CTimerWheel::ForEach(F func)
+{
+	auto walk = [&func](CTimerBase** ppList) {
+		for (CTimerBase* pTimer = *ppList; pTimer;)
+		{
+			CTimerBase* pNext = pTimer->m_pWheelNext;
+			func(pTimer);
+			pTimer = pNext;
+		}
+	};
+
+	walk(&m_pPending);
+	walk(&m_pHeld);
+	walk(&m_pRunning);
+	walk(&m_pFired);
+
+	for (int i = 0; i < TIMER_WHEEL_ROOT_SIZE; i++)
+		walk(&m_pRoot[i]);
+
+	for (int i = 0; i < TIMER_WHEEL_LEVELS; i++)
+		for (int j = 0; j < TIMER_WHEEL_LEVEL_SIZE; j++)
+			walk(&m_pLevels[i][j]);
+}
+
+void AddTimer(CTimerBase* pTimer)
+{
+	g_timerWheel.Add(pTimer);
+}
+
+void RunTimers()
+{
+	g_timerWheel.Run(g_flUniversalTime);
+}
+
+bool IsTimerActive(CTimerHandle hTimer)
+{
+	return g_timerPool.Get(hTimer) != nullptr;
+}
+
+bool CancelTimer(CTimerHandle hTimer)
+{
+	CTimer* pTimer = g_timerPool.Get(hTimer);
+
+	if (!pTimer)
+		return false;
+
+	g_timerWheel.Cancel(pTimer);
+	return true;
+}
+
+bool RescheduleTimer(CTimerHandle hTimer, float flInterval)
+{
+	CTimer* pTimer = g_timerPool.Get(hTimer);
+
+	if (!pTimer)
+		return false;
+
+	g_timerWheel.Reschedule(pTimer, flInterval, g_flUniversalTime);
+	return true;
+}
+
+float GetTimerTimeLeft(CTimerHandle hTimer)
+{
+	CTimer* pTimer = g_timerPool.Get(hTimer);
+
+	if (!pTimer)
+		return -1.0f;
+
+	return g_timerWheel.GetTimeLeft(pTimer, g_flUniversalTime);
+}
+
+CDeferredActionQueue g_deferredActions;
+
+void CDeferredActionQueue::Run()
+{
+	// Anything pushed while running is left for the next frame
+	uint32 iTail = m_iTail.load(std::memory_order_acquire);
+	size_t nSpilled = m_vecSpilled.size();
+
+	for (uint32 iHead = m_iHead.load(std::memory_order_relaxed); iHead != iTail; iHead++)
+	{
+		DeferredAction_t& action = m_actions[iHead % DEFERRED_ACTION_CAPACITY];
+		CDeferredFunc* pFunc = action.Get();
+
+		if (action.iRoundNum == g_iRoundNum)
+			(*pFunc)();
+
+		pFunc->~CDeferredFunc();
+		m_iHead.store(iHead + 1, std::memory_order_release);
+	}
+
+	if (nSpilled == 0)
+		return;
+
+	for (size_t i = 0; i < nSpilled; i++)
+	{
+		if (m_vecSpilled[i].iRoundNum == g_iRoundNum)
+			(*m_vecSpilled[i].pFunc)();
+
+		delete m_vecSpilled[i].pFunc;
+	}
+
+	m_vecSpilled.erase(m_vecSpilled.begin(), m_vecSpilled.begin() + nSpilled);
+}
+
+void CDeferredActionQueue::Clear()
+{
+	uint32 iTail = m_iTail.load(std::memory_order_acquire);
+
+	for (uint32 iHead = m_iHead.load(std::memory_order_relaxed); iHead != iTail; iHead++)
+		m_actions[iHead % DEFERRED_ACTION_CAPACITY].Get()->~CDeferredFunc();
+
+	m_iHead.store(iTail, std::memory_order_release);
+
+	for (SpilledAction_t& action : m_vecSpilled)
+		delete action.pFunc;
+
+	m_vecSpilled.clear();
+}
+
+void RunDeferredActions()
+{
+	g_deferredActions.Run();
+}
+
+void RemoveTimers()
+{
+	g_deferredActions.Clear();
+
+	g_timerWheel.ForEach([](CTimerBase* pTimer) {
+		g_timerWheel.Remove(pTimer);
+		delete pTimer;
+	});
+}
+
+void RemoveMapTimers()
+{
+	g_deferredActions.Clear();
+
+	g_timerWheel.ForEach([](CTimerBase* pTimer) {
+		if (pTimer->m_bPreserveMapChange)
+			return;
+
+		g_timerWheel.Remove(pTimer);
+		delete pTimer;
+	});
+}
+
+CON_COMMAND_F(cs2f_timer_stats, "- Print timer allocation statistics", FCVAR_SPONLY | FCVAR_LINKED_CONCOMMAND)
+{
+	Message("Timers alive: %llu\n", g_timerAllocStats.iTimerAllocs - g_timerAllocStats.iTimerFrees);
+	Message("Timers allocated from pool: %llu, freed: %llu\n", g_timerAllocStats.iTimerAllocs, g_timerAllocStats.iTimerFrees);
+	Message("Pool slabs allocated: %llu (%i timers each)\n", g_timerAllocStats.iSlabAllocs, TIMER_POOL_SLAB_SIZE);
+	Message("Timer functions stored on the heap: %llu\n", g_timerAllocStats.iFuncHeapAllocs);
+	Message("Next frame actions spilled out of the ring buffer: %llu\n", g_timerAllocStats.iDeferredSpills);
+}
+
+CON_COMMAND_F(cs2f_timer_profile_dump, "<count> - Print the timer creation sites with the highest total execution time, recorded while cs2f_timer_profile is on", FCVAR_SPONLY | FCVAR_LINKED_CONCOMMAND)
+{
+	int iCount = args.ArgC() > 1 ? V_StringToInt32(args[1], 20) : 20;
+
+	std::vector<const TimerSiteStats_t*> vecSites;
+	vecSites.reserve(g_mapTimerSiteStats.size());
+
+	for (const auto& [site, stats] : g_mapTimerSiteStats)
+		vecSites.push_back(&stats);
+
+	std::sort(vecSites.begin(), vecSites.end(), [](const TimerSiteStats_t* a, const TimerSiteStats_t* b) {
+		return a->flTotalTime > b->flTotalTime;
+	});
+
+	Message("%10s %12s %10s %10s  %s\n", "calls", "total ms", "avg us", "max us", "site");
+
+	for (int i = 0; i < iCount && i < vecSites.size(); i++)
+	{
+		const TimerSiteStats_t* pStats = vecSites[i];
+
+		Message("%10llu %12.3f %10.2f %10.2f  %s:%u (%s)\n", pStats->iCalls, pStats->flTotalTime * 1000.0, pStats->flTotalTime * 1000000.0 / pStats->iCalls,
+				pStats->flMaxTime * 1000000.0, pStats->location.file_name(), pStats->location.line(), pStats->location.function_name());
+	}
+}
+
+CON_COMMAND_F(cs2f_timer_profile_reset, "- Clear the timer execution times recorded so far", FCVAR_SPONLY | FCVAR_LINKED_CONCOMMAND)
+{
+	g_mapTimerSiteStats.clear();
+	Message("Timer profile reset\n");
 }
\ No newline at end of file
@@ -18,8 +18,15 @@
  */
 
 #pragma once
-#include "utllinkedlist.h"
+#include "platform.h"
+#include <atomic>
+#include <cstddef>
 #include <functional>
+#include <new>
+#include <source_location>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 extern int g_iRoundNum;
 
@@ -32,6 +39,8 @@ public:
 		m_iRoundNum = g_iRoundNum;
 	}
 
+	virtual ~CTimerBase() = default;
+
 	virtual bool Execute() = 0;
 
 	float m_flInterval;
@@ -39,19 +48,96 @@ public:
 	bool m_bPreserveMapChange;
 	bool m_bPreserveRoundChange;
 	int m_iRoundNum;
+
+	// Where the timer was created, for cs2f_timer_profile
+	std::source_location m_location;
+
+	// Timing wheel bookkeeping, only touched by ctimer.cpp
+	double m_flNextExecute = -1;
+	CTimerBase** m_ppWheelList = nullptr;
+	CTimerBase* m_pWheelPrev = nullptr;
+	CTimerBase* m_pWheelNext = nullptr;
+};
+
+// Hands the timer over to the timing wheel, it gets scheduled on the next RunTimers call
+void AddTimer(CTimerBase* pTimer);
+
+struct TimerAllocStats_t
+{
+	uint64 iTimerAllocs;	// Timers handed out by the pool
+	uint64 iTimerFrees;		// Timers given back to the pool
+	uint64 iSlabAllocs;		// Heap allocations made by the pool to grow
+	uint64 iFuncHeapAllocs; // Timer functions that were too big to be stored inline
+	uint64 iDeferredSpills; // Next frame actions that didn't fit in the ring buffer
+};
+
+extern TimerAllocStats_t g_timerAllocStats;
+
+// Enough for lambdas capturing a few handles and ints, or a std::string
+#define TIMER_FUNC_INLINE_SIZE 64
+
+// Type erased callable, like std::function but keeping small functions inside the timer itself
+template <typename R>
+class CInlineFunc
+{
+public:
+	template <typename F, typename Fn = std::decay_t<F>>
+		requires(!std::is_same_v<Fn, CInlineFunc>)
+	CInlineFunc(F&& func)
+	{
+		if constexpr (sizeof(Fn) <= TIMER_FUNC_INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t))
+		{
+			m_pFunc = new (m_storage) Fn(std::forward<F>(func));
+			m_pfnDestroy = [](void* pFunc) { static_cast<Fn*>(pFunc)->~Fn(); };
+		}
+		else
+		{
+			m_pFunc = new Fn(std::forward<F>(func));
+			m_pfnDestroy = [](void* pFunc) { delete static_cast<Fn*>(pFunc); };
+			g_timerAllocStats.iFuncHeapAllocs++;
+		}
+
+		m_pfnInvoke = [](void* pFunc) { return (R)(*static_cast<Fn*>(pFunc))(); };
+	}
+
+	~CInlineFunc() { m_pfnDestroy(m_pFunc); }
+
+	CInlineFunc(const CInlineFunc&) = delete;
+	CInlineFunc& operator=(const CInlineFunc&) = delete;
+
+	R operator()() { return m_pfnInvoke(m_pFunc); }
+
+private:
+	alignas(std::max_align_t) unsigned char m_storage[TIMER_FUNC_INLINE_SIZE];
+	void* m_pFunc;
+	R (*m_pfnInvoke)(void*);
+	void (*m_pfnDestroy)(void*);
 };
 
-extern CUtlLinkedList<CTimerBase*> g_timers;
+using CTimerFunc = CInlineFunc<float>;
+using CDeferredFunc = CInlineFunc<void>;
+
+// Refers to a CTimer without owning it, the serial makes handles to timers that already finished (or had their memory reused) harmless
+struct CTimerHandle
+{
+	uint32 m_iIndex = (uint32)-1;
+	uint32 m_iSerial = 0;
+
+	bool operator==(const CTimerHandle& other) const = default;
+};
 
 // Timer functions should return the time until next execution, or a negative value like -1.0f to stop
 // Having an interval of 0 is fine, in this case it will run on every game frame
-class CTimer : public CTimerBase
+class CTimer final : public CTimerBase
 {
 public:
-	CTimer(float flInitialInterval, bool bPreserveMapChange, bool bPreserveRoundChange, std::function<float()> func) :
-		CTimerBase(flInitialInterval, bPreserveMapChange, bPreserveRoundChange), m_func(func)
+	template <typename F>
+	CTimer(float flInitialInterval, bool bPreserveMapChange, bool bPreserveRoundChange, F&& func,
+		   const std::source_location& location = std::source_location::current()) :
+		CTimerBase(flInitialInterval, bPreserveMapChange, bPreserveRoundChange), m_func(std::forward<F>(func))
 	{
-		g_timers.AddToTail(this);
+		m_location = location;
+		AddTimer(this);
 	};
 
 	inline bool Execute() override
@@ -61,8 +147,93 @@ public:
 		return m_flInterval >= 0;
 	}
 
-	std::function<float()> m_func;
+	CTimerHandle GetHandle() const;
+
+	// Timers are allocated from a slab pool instead of the general heap, see ctimer.cpp
+	static void* operator new(size_t size);
+	static void operator delete(void* pMem);
+
+	CTimerFunc m_func;
 };
 
+// Same as new CTimer, but returns a handle that can later be used to cancel or change the timer
+template <typename F>
+CTimerHandle CreateTimer(float flInitialInterval, bool bPreserveMapChange, bool bPreserveRoundChange, F&& func,
+						 const std::source_location& location = std::source_location::current())
+{
+	return (new CTimer(flInitialInterval, bPreserveMapChange, bPreserveRoundChange, std::forward<F>(func), location))->GetHandle();
+}
+
+// All of these are O(1) and safe to call with stale handles, in which case they return false (or -1 for time left)
+bool IsTimerActive(CTimerHandle hTimer);
+bool CancelTimer(CTimerHandle hTimer);
+// Sets the time until the next execution, doing this from inside the timer's own function has no effect, return the new interval instead
+bool RescheduleTimer(CTimerHandle hTimer, float flInterval);
+float GetTimerTimeLeft(CTimerHandle hTimer);
+
+// Enough for a frame of GameUI and strip inputs during a map start spawn storm
+#define DEFERRED_ACTION_CAPACITY 512
+
+// Single producer ring buffer of functions to run once on the next frame, used instead of 0 delay timers
+// Overflowing actions spill into a heap allocated list, which keeps taking new actions until drained so order is preserved
+class CDeferredActionQueue
+{
+public:
+	~CDeferredActionQueue() { Clear(); }
+
+	template <typename F>
+	void Push(F&& func)
+	{
+		uint32 iTail = m_iTail.load(std::memory_order_relaxed);
+
+		if (m_vecSpilled.empty() && iTail - m_iHead.load(std::memory_order_acquire) < DEFERRED_ACTION_CAPACITY)
+		{
+			DeferredAction_t& action = m_actions[iTail % DEFERRED_ACTION_CAPACITY];
+			new (action.storage) CDeferredFunc(std::forward<F>(func));
+			action.iRoundNum = g_iRoundNum;
+			m_iTail.store(iTail + 1, std::memory_order_release);
+			return;
+		}
+
+		m_vecSpilled.push_back({new CDeferredFunc(std::forward<F>(func)), g_iRoundNum});
+		g_timerAllocStats.iDeferredSpills++;
+	}
+
+	void Run();
+	void Clear();
+
+private:
+	struct DeferredAction_t
+	{
+		alignas(CDeferredFunc) unsigned char storage[sizeof(CDeferredFunc)];
+		int iRoundNum;
+
+		CDeferredFunc* Get() { return std::launder(reinterpret_cast<CDeferredFunc*>(storage)); }
+	};
+
+	struct SpilledAction_t
+	{
+		CDeferredFunc* pFunc;
+		int iRoundNum;
+	};
+
+	DeferredAction_t m_actions[DEFERRED_ACTION_CAPACITY];
+	std::atomic<uint32> m_iHead = 0;
+	std::atomic<uint32> m_iTail = 0;
+	std::vector<SpilledAction_t> m_vecSpilled;
+};
+
+extern CDeferredActionQueue g_deferredActions;
+
+// Runs func once at the start of the next frame, like a 0 delay CTimer that doesn't preserve round changes
+template <typename F>
+void RunNextFrame(F&& func)
+{
+	g_deferredActions.Push(std::forward<F>(func));
+}
+
+// Executes every timer that is due at g_flUniversalTime, cost scales with the number of timers firing rather than alive
+void RunTimers();
+void RunDeferredActions();
 void RemoveTimers();
 void RemoveMapTimers();
\ No newline at end of file
@@ -148,11 +148,9 @@ static void DelayInput(CBaseEntity* pCaller, const char* input, const char* para
 {
 	const auto eh = pCaller->GetHandle();
 
-	new CTimer(0.f, false, false, [eh, input, param]() {
+	RunNextFrame([eh, input, param]() {
 		if (const auto entity = reinterpret_cast<CBaseEntity*>(eh.Get()))
 			entity->AcceptInput(input, param, nullptr, entity);
-
-		return -1.f;
 	});
 }
 
@@ -162,12 +160,10 @@ static void DelayInput(CBaseEntity* pCaller, CBaseEntity* pActivator, const char
 	const auto eh = pCaller->GetHandle();
 	const auto ph = pActivator->GetHandle();
 
-	new CTimer(0.f, false, false, [eh, ph, input, param]() {
+	RunNextFrame([eh, ph, input, param]() {
 		const auto player = reinterpret_cast<CBaseEntity*>(ph.Get());
 		if (const auto entity = reinterpret_cast<CBaseEntity*>(eh.Get()))
 			entity->AcceptInput(input, param, player, entity);
-
-		return -1.f;
 	});
 }
 
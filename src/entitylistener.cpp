@@ -26,6 +26,7 @@
 #include "entwatch.h"
 #include "gameconfig.h"
 #include "plat.h"
+#include "playermanager.h"
 
 extern CGameConfig* g_GameConfig;
 extern CCSGameRules* g_pGameRules;
@@ -72,6 +73,7 @@ void CEntityListener::OnEntityCreated(CEntityInstance* pEntity)
 void CEntityListener::OnEntityDeleted(CEntityInstance* pEntity)
 {
 	EW_OnEntityDeleted(pEntity);
+	g_playerManager->OnEntityDeleted(pEntity);
 }
 
 void CEntityListener::OnEntityParentChanged(CEntityInstance* pEntity, CEntityInstance* pNewParent)
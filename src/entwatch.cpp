@@ -1622,10 +1622,9 @@ void CEWHandler::PlayerPickup(CCSPlayerPawn* pPawn, int iItemInstance)
 
 	item->Pickup(pPawn->m_hOriginalController->GetPlayerSlot());
 
-	if (g_cvarEnableEntwatchHud.Get() && !m_bHudTicking)
+	if (g_cvarEnableEntwatchHud.Get() && !IsTimerActive(m_hHudTimer))
 	{
-		m_bHudTicking = true;
-		new CTimer(EW_HUD_TICKRATE, false, false, [] {
+		m_hHudTimer = CreateTimer(EW_HUD_TICKRATE, false, false, [] {
 			return EW_UpdateHud();
 		});
 	}
@@ -1981,10 +1980,12 @@ float EW_UpdateHud()
 		if (!pItem->bShowHud)
 			continue;
 
-		CCSPlayerController* pOwner = CCSPlayerController::FromSlot(CPlayerSlot(pItem->iOwnerSlot));
-		if (!pOwner)
+		const PlayerSnapshot_t* pOwnerSnapshot = g_playerManager->GetSnapshot(CPlayerSlot(pItem->iOwnerSlot));
+		if (!pOwnerSnapshot)
 			continue;
 
+		CCSPlayerController* pOwner = pOwnerSnapshot->pController;
+
 		std::string sItemText = pItem->GetHandlerStateText();
 
 		// TODO: std::format not supported in clang16 by default
@@ -2024,11 +2025,8 @@ float EW_UpdateHud()
 
 	for (int i = 0; i < GetGlobals()->maxClients; i++)
 	{
-		CCSPlayerController* pController = CCSPlayerController::FromSlot(i);
-		if (!pController)
-			continue;
-		auto pPawn = pController->GetPawn();
-		if (!pPawn)
+		const PlayerSnapshot_t* pSnapshot = g_playerManager->GetSnapshot(i);
+		if (!pSnapshot || !pSnapshot->pPawn)
 			continue;
 		ZEPlayer* zpPlayer = g_playerManager->GetPlayer(CPlayerSlot(i));
 		if (!zpPlayer)
@@ -2064,7 +2062,7 @@ void EW_RoundPreStart()
 
 	g_pEWHandler->ResetAllClantags();
 	g_pEWHandler->ClearItems();
-	g_pEWHandler->m_bHudTicking = false;
+	CancelTimer(g_pEWHandler->m_hHudTimer);
 }
 
 void EW_OnEntitySpawned(CEntityInstance* pEntity)
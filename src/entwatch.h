@@ -208,7 +208,6 @@ public:
 	CEWHandler()
 	{
 		bConfigLoaded = false;
-		m_bHudTicking = false;
 
 		iBaseBtnUseHookId = -1;
 		iPhysboxUseHookId = -1;
@@ -275,7 +274,7 @@ public:
 	int iRotBtnUseHookId;
 	int iMomRotBtnUseHookId;
 
-	bool m_bHudTicking;
+	CTimerHandle m_hHudTimer;
 
 	std::map<int, std::shared_ptr<ETransferInfo>> mapTransfers; // Any etransfers that target multiple items
 };
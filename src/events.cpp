@@ -153,27 +153,25 @@ GAME_EVENT_F(player_spawn)
 	CHandle<CCSPlayerController> hController = pController->GetHandle();
 
 	// Gotta do this on the next frame...
-	new CTimer(0.0f, false, false, [hController]() {
+	RunNextFrame([hController]() {
 		CCSPlayerController* pController = hController.Get();
 
 		if (!pController)
-			return -1.0f;
+			return;
 
 		if (const auto player = pController->GetZEPlayer())
 			player->SetSteamIdAttribute();
 
 		if (!pController->m_bPawnIsAlive())
-			return -1.0f;
+			return;
 
 		CBasePlayerPawn* pPawn = pController->GetPawn();
 
 		// Just in case somehow there's health but the player is, say, an observer
 		if (!g_cvarNoblock.Get() || !pPawn || !pPawn->IsAlive())
-			return -1.0f;
+			return;
 
 		pPawn->SetCollisionGroup(COLLISION_GROUP_DEBRIS);
-
-		return -1.0f;
 	});
 
 	CCSPlayerPawn* pPawn = (CCSPlayerPawn*)pController->GetPawn();
@@ -1,5 +1,7 @@
 #include "gameconfig.h"
 #include "addresses.h"
+#include "filesystem.h"
+#include "schema.h"
 
 CGameConfig::CGameConfig(const std::string& gameDir, const std::string& path)
 {
@@ -11,6 +13,7 @@ CGameConfig::CGameConfig(const std::string& gameDir, const std::string& path)
 CGameConfig::~CGameConfig()
 {
 	delete m_pKeyValues;
+	delete m_pNewSignatureCache;
 }
 
 bool CGameConfig::Init(IFileSystem* filesystem, char* conf_error, int conf_error_size)
@@ -182,14 +185,24 @@ void* CGameConfig::ResolveSignature(const char* name)
 			return nullptr;
 		}
 
-		size_t iLength = 0;
-		byte* pSignature = HexToByte(signature, iLength);
-		if (!pSignature)
-			return nullptr;
-
 		int error;
+		auto it = m_umScannedSignatures.find(name);
 
-		address = (*module)->FindSignature(pSignature, iLength, error);
+		if (it != m_umScannedSignatures.end())
+		{
+			address = it->second.first;
+			error = it->second.second;
+		}
+		else
+		{
+			size_t iLength = 0;
+			byte* pSignature = HexToByte(signature, iLength);
+			if (!pSignature)
+				return nullptr;
+
+			address = (*module)->FindSignature(pSignature, iLength, error);
+			delete[] pSignature;
+		}
 
 		if (error == SIG_FOUND_MULTIPLE)
 			Panic("!!!!!!!!!! Signature for %s occurs multiple times! Using first match but this might end up crashing!\n", name);
@@ -203,6 +216,163 @@ void* CGameConfig::ResolveSignature(const char* name)
 	return address;
 }
 
+// Finds every signature of a module in one pass instead of scanning it again for each one, ResolveSignature looks these up
+// once CommitSignatureScans is done. Modules have to be loaded first, signatures of modules that aren't are still resolved one at a time.
+// With a cache path, where each signature matched last time in the same build of the module is checked first,
+// and only the ones that no longer match there are scanned for. The scans are split into ranges that run on the pool
+void CGameConfig::QueueSignatureScans(CTaskPool& pool, const char* pszCachePath)
+{
+	KeyValues* pCache = new KeyValues("SignatureCache");
+	KeyValues::AutoDelete autoDelete(pCache);
+
+	if (pszCachePath)
+		pCache->LoadFromFile(g_pFullFileSystem, pszCachePath);
+
+	// What gets saved, every unique match of this load
+	m_pNewSignatureCache = new KeyValues("SignatureCache");
+	m_strSignatureCachePath = pszCachePath ? pszCachePath : "";
+	m_vecPendingScans.clear();
+
+	std::unordered_map<CModule*, size_t> scanIndices;
+	std::vector<KeyValues*> cacheKeys;
+
+	for (const auto& [name, signature] : m_umSignatures)
+	{
+		if (signature.empty() || signature[0] == '@')
+			continue;
+
+		CModule** module = GetModule(name.c_str());
+		if (!module || !(*module))
+			continue;
+
+		CModule* pModule = *module;
+		auto it = scanIndices.find(pModule);
+
+		if (it == scanIndices.end())
+		{
+			it = scanIndices.emplace(pModule, m_vecPendingScans.size()).first;
+
+			PendingScan_t& scan = m_vecPendingScans.emplace_back();
+			scan.pModule = pModule;
+			scan.pNewCacheKey = nullptr;
+			scan.nCacheHits = 0;
+
+			std::string buildId = pModule->GetBuildId();
+			KeyValues* pCacheKey = pCache->FindKey(pModule->m_pszModule);
+
+			// Offsets are only worth checking if they were found in this exact build of the module
+			cacheKeys.push_back((pCacheKey && !buildId.empty() && buildId == pCacheKey->GetString("buildid")) ? pCacheKey : nullptr);
+			scan.bCacheValid = cacheKeys.back() != nullptr;
+
+			if (!buildId.empty())
+			{
+				scan.pNewCacheKey = new KeyValues(pModule->m_pszModule);
+				scan.pNewCacheKey->SetString("buildid", buildId.c_str());
+				m_pNewSignatureCache->AddSubKey(scan.pNewCacheKey);
+			}
+		}
+
+		PendingScan_t& scan = m_vecPendingScans[it->second];
+		KeyValues* pCacheKey = cacheKeys[it->second];
+
+		size_t iLength = 0;
+		byte* pSignature = HexToByte(signature.c_str(), iLength);
+		if (!pSignature)
+			continue;
+
+		KeyValues* pEntry = pCacheKey ? pCacheKey->FindKey(name.c_str()) : nullptr;
+
+		if (pEntry && pEntry->GetUint64("hash") == hash_64_fnv1a_const(signature.c_str()))
+		{
+			uint64 iOffset = pEntry->GetUint64("offset", UINT64_MAX);
+			uint8_t* pMatch = (uint8_t*)pModule->m_base + iOffset;
+
+			if (iOffset <= pModule->m_size && iLength <= pModule->m_size - iOffset && CSignatureScanner::Matches(pMatch, pSignature, iLength))
+			{
+				m_umScannedSignatures[name] = std::make_pair(CSignatureScanner::FollowRelative(pMatch), SIG_OK);
+				CacheSignatureOffset(scan.pNewCacheKey, name.c_str(), signature.c_str(), iOffset);
+				scan.nCacheHits++;
+				delete[] pSignature;
+				continue;
+			}
+		}
+
+		scan.scanner.AddSignature(pSignature, iLength);
+		scan.names.push_back(name);
+
+		delete[] pSignature;
+	}
+
+	// Nothing is added to m_vecPendingScans past here, so the jobs can point into it
+	const size_t iRangeSize = 4 * 1024 * 1024;
+
+	for (PendingScan_t& scan : m_vecPendingScans)
+	{
+		if (!scan.scanner.Count())
+			continue;
+
+		scan.scanner.Prepare(scan.pModule->m_base, scan.pModule->m_size);
+		scan.rangeResults.resize((scan.pModule->m_size + iRangeSize - 1) / iRangeSize);
+
+		for (size_t i = 0; i < scan.rangeResults.size(); i++)
+			pool.Add([&scan, i, iRangeSize] { scan.scanner.ScanRange(i * iRangeSize, (i + 1) * iRangeSize, scan.rangeResults[i]); });
+	}
+}
+
+// Has to wait for the pool running the scans
+void CGameConfig::CommitSignatureScans()
+{
+	KeyValues* pNewCache = m_pNewSignatureCache;
+	KeyValues::AutoDelete autoDelete(pNewCache);
+	m_pNewSignatureCache = nullptr;
+
+	bool bCacheChanged = false;
+
+	for (PendingScan_t& scan : m_vecPendingScans)
+	{
+		for (const auto& results : scan.rangeResults)
+			scan.scanner.AddResults(results);
+
+		for (int i = 0; i < scan.scanner.Count(); i++)
+		{
+			int error;
+			void* address = scan.scanner.GetResult(i, error);
+			m_umScannedSignatures[scan.names[i]] = std::make_pair(address, error);
+
+			// Only unique matches are remembered, anything else is scanned for again next time so it gets reported again
+			if (scan.pNewCacheKey && error == SIG_OK)
+				CacheSignatureOffset(scan.pNewCacheKey, scan.names[i].c_str(), GetSignature(scan.names[i]), (uintptr_t)scan.scanner.GetMatch(i) - (uintptr_t)scan.pModule->m_base);
+		}
+
+		if (scan.scanner.Count() || !scan.bCacheValid)
+			bCacheChanged = true;
+
+		Message("Scanned %s for %i signatures, %i found from the cache\n", scan.pModule->m_pszModule, scan.scanner.Count(), scan.nCacheHits);
+	}
+
+	m_vecPendingScans.clear();
+
+	if (m_strSignatureCachePath.empty() || !bCacheChanged)
+		return;
+
+	char szPath[MAX_PATH];
+	V_snprintf(szPath, sizeof(szPath), "%s%s%s", Plat_GetGameDirectory(), "/csgo/", m_strSignatureCachePath.c_str());
+
+	// Create the directory in case it doesn't exist
+	g_pFullFileSystem->CreateDirHierarchyForFile(szPath, nullptr);
+
+	if (!pNewCache->SaveToFile(g_pFullFileSystem, szPath))
+		Warning("Failed to save signature cache to %s\n", szPath);
+}
+
+void CGameConfig::CacheSignatureOffset(KeyValues* pModuleKey, const char* pszName, const char* pszSignature, uint64 iOffset)
+{
+	KeyValues* pEntry = new KeyValues(pszName);
+	pEntry->AddUint64("hash", hash_64_fnv1a_const(pszSignature));
+	pEntry->AddUint64("offset", iOffset);
+	pModuleKey->AddSubKey(pEntry);
+}
+
 // Static functions
 std::string CGameConfig::GetDirectoryName(const std::string& directoryPathInput)
 {
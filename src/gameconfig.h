@@ -1,10 +1,13 @@
 #pragma once
 
 #include "KeyValues.h"
+#include "utils/signature_scanner.h"
+#include "utils/task_pool.h"
 
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class CModule;
 
@@ -25,6 +28,8 @@ public:
 	CModule** GetModule(const char* name);
 	bool IsSymbol(const char* name);
 	void* ResolveSignature(const char* name);
+	void QueueSignatureScans(CTaskPool& pool, const char* pszCachePath = nullptr);
+	void CommitSignatureScans();
 	static std::string GetDirectoryName(const std::string& directoryPathInput);
 	static int HexStringToUint8Array(const char* hexString, uint8_t* byteArray, size_t maxBytes);
 	static byte* HexToByte(const char* src, size_t& length);
@@ -38,4 +43,25 @@ private:
 	std::unordered_map<std::string, void*> m_umAddresses;
 	std::unordered_map<std::string, std::string> m_umLibraries;
 	std::unordered_map<std::string, std::string> m_umPatches;
+
+	// Filled by CommitSignatureScans, address and SigError of every signature found in the batch scan
+	std::unordered_map<std::string, std::pair<void*, int>> m_umScannedSignatures;
+
+	// Scans running between QueueSignatureScans and CommitSignatureScans
+	struct PendingScan_t
+	{
+		CModule* pModule;
+		CSignatureScanner scanner;
+		std::vector<std::string> names;
+		std::vector<std::vector<CSignatureScanner::Result_t>> rangeResults;
+		KeyValues* pNewCacheKey;
+		bool bCacheValid;
+		int nCacheHits;
+	};
+
+	std::vector<PendingScan_t> m_vecPendingScans;
+	KeyValues* m_pNewSignatureCache = nullptr;
+	std::string m_strSignatureCachePath;
+
+	static void CacheSignatureOffset(KeyValues* pModuleKey, const char* pszName, const char* pszSignature, uint64 iOffset);
 };
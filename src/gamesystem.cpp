@@ -170,6 +170,7 @@ GS_EVENT_MEMBER(CGameSystem, BuildGameSessionManifest)
 GS_EVENT_MEMBER(CGameSystem, ServerPreEntityThink)
 {
 	VPROF_BUDGET("CGameSystem::ServerPreEntityThink", "CS2FixesPerFrame")
+	g_playerManager->UpdateSnapshot();
 	g_playerManager->FlashLightThink();
 	g_pIdleSystem->UpdateIdleTimes();
 
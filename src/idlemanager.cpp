@@ -96,21 +96,11 @@ void CIdleSystem::UpdateIdleTimes()
 		if (!pPlayer)
 			continue;
 
-		CBasePlayerController* pTarget = (CBasePlayerController*)g_pEntitySystem->GetEntityInstance((CEntityIndex)(pPlayer->GetPlayerSlot().Get() + 1));
-		if (!pTarget)
+		const PlayerSnapshot_t* pSnapshot = g_playerManager->GetSnapshot(pPlayer->GetPlayerSlot());
+		if (!pSnapshot || !pSnapshot->pPawn)
 			continue;
 
-		const auto pPawn = pTarget->m_hPawn();
-		if (!pPawn)
-			continue;
-
-		const auto pMovement = pPawn->m_pMovementServices();
-		uint64 iCurrentMovement = IN_NONE;
-		if (pMovement)
-		{
-			const auto buttonStates = pMovement->m_nButtons().m_pButtonStates();
-			iCurrentMovement = buttonStates[0];
-		}
+		uint64 iCurrentMovement = pSnapshot->bHasButtons ? pSnapshot->iButtons[0] : IN_NONE;
 		const auto buttonsChanged = pPlayer->GetLastInputs() ^ iCurrentMovement;
 
 		if (!buttonsChanged)
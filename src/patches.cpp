@@ -51,6 +51,7 @@ CConVar<bool> cs2f_movement_unlocker_enable("cs2f_movement_unlocker_enable", FCV
 bool InitPatches(CGameConfig* g_GameConfig)
 {
 	bool success = true;
+	CMemoryWriteBatch writeBatch;
 
 	// Skip first patch (movement unlocker), it gets patched in convar callback
 	for (int i = 1; i < sizeof(g_CommonPatches) / sizeof(*g_CommonPatches); i++)
@@ -62,6 +63,8 @@ bool InitPatches(CGameConfig* g_GameConfig)
 
 void UndoPatches()
 {
+	CMemoryWriteBatch writeBatch;
+
 	for (int i = 0; i < sizeof(g_CommonPatches) / sizeof(*g_CommonPatches); i++)
 		g_CommonPatches[i].UndoPatch();
 }
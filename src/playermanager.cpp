@@ -34,9 +34,13 @@
 #include "tier0/vprof.h"
 #include "user_preferences.h"
 #include "utils/entity.h"
+#include "utils/spatial_grid.h"
 #include "utlstring.h"
 #include "votemanager.h"
 #include <../cs2fixes.h>
+#include <bit>
+#include <list>
+#include <unordered_map>
 
 #include "tier0/memdbgon.h"
 
@@ -47,6 +51,8 @@ extern IGameEventSystem* g_gameEventSystem;
 extern CUtlVector<CServerSideClient*>* GetClientList();
 extern CSpawnGroupMgrGameSystem* g_pSpawnGroupMgr;
 
+PlayerHotData_t g_playerHotData;
+
 CConVar<int> g_cvarAdminImmunityTargetting("cs2f_admin_immunity", FCVAR_NONE, "Mode for which admin immunity system targetting allows: 0 - strictly lower, 1 - equal to or lower, 2 - ignore immunity levels", 0, true, 0, true, 2);
 CConVar<bool> g_cvarEnableMapSteamIds("cs2f_map_steamids_enable", FCVAR_NONE, "Whether to make Steam ID's available to maps", false);
 
@@ -105,13 +111,12 @@ void ZEPlayer::OnSpawn()
 	SetSpeedMod(1.f);
 
 	ZEPlayerHandle handle = GetHandle();
-	new CTimer(0.0f, false, false, [handle] {
+	RunNextFrame([handle] {
 		if (handle.Get())
 		{
 			handle.Get()->CreatePointOrient();
 			handle.Get()->CreateEntwatchHud();
 		}
-		return -1.0f;
 	});
 }
 
@@ -122,6 +127,8 @@ void ZEPlayer::OnAuthenticated()
 
 	Message("%lli authenticated\n", GetSteamId64());
 
+	g_playerManager->OnPlayerAuthenticated(this);
+
 	CheckAdmin();
 	CheckInfractions();
 	g_pUserPreferencesSystem->PullPreferences(GetPlayerSlot().Get());
@@ -161,7 +168,8 @@ extern CConVar<int> g_cvarMaxHideDistance;
 
 int ZEPlayer::GetHideDistance()
 {
-	int v = g_pUserPreferencesSystem->GetPreferenceInt(m_slot.Get(), HIDE_DISTANCE_PREF_KEY_NAME, 0);
+	// Kept in sync with the preference by CUserPreferencesSystem::SetPreference
+	int v = g_playerHotData.iHideDistance[m_slot.Get()];
 	int max = g_cvarMaxHideDistance.Get(); // hide 不能设置超过最大值
 	if (v > max)
 		v = max;
@@ -302,7 +310,7 @@ void ZEPlayer::StartBeacon(Color color, ZEPlayerHandle hGiver /* = 0*/)
 	particle->DispatchSpawn();
 	particle->SetParent(pPlayer->GetPawn());
 
-	m_hBeaconParticle.Set(particle);
+	SetBeaconParticle(particle);
 
 	CHandle<CParticleSystem> hParticle = particle->GetHandle();
 	ZEPlayerHandle hPlayer = m_Handle;
@@ -361,7 +369,7 @@ void ZEPlayer::EndBeacon()
 {
 	SetBeaconColor(Color(0, 0, 0, 0));
 
-	CParticleSystem* pParticle = m_hBeaconParticle.Get();
+	CParticleSystem* pParticle = GetBeaconParticle();
 
 	if (pParticle)
 		addresses::UTIL_Remove(pParticle);
@@ -461,9 +469,9 @@ void ZEPlayer::StartGlow(Color color, int duration)
 	pModelRelay->AcceptInput("FollowEntity", "!activator", pPawn);
 	pModelGlow->AcceptInput("FollowEntity", "!activator", pModelRelay);
 
-	m_hGlowModel.Set(pModelGlow);
+	SetGlowModel(pModelGlow);
 
-	CHandle<CBaseModelEntity> hGlowModel = m_hGlowModel;
+	CHandle<CBaseModelEntity> hGlowModel = g_playerHotData.hGlowModel[m_slot.Get()];
 	CHandle<CCSPlayerPawn> hPawn = pPawn->GetHandle();
 	int iTeamNum = hPawn->m_iTeamNum();
 
@@ -521,7 +529,7 @@ void ZEPlayer::EndGlow()
 {
 	SetGlowColor(Color(0, 0, 0, 0));
 
-	CBaseModelEntity* pGlowModel = m_hGlowModel.Get();
+	CBaseModelEntity* pGlowModel = GetGlowModel();
 
 	if (!pGlowModel)
 		return;
@@ -752,6 +760,9 @@ void ZEPlayer::SetEntwatchHudSize(float flSize)
 void CPlayerManager::OnBotConnected(CPlayerSlot slot)
 {
 	m_vecPlayers[slot.Get()] = new ZEPlayer(slot, true);
+
+	m_iConnectedMask |= 1ull << slot.Get();
+	m_iFakeClientMask |= 1ull << slot.Get();
 }
 
 bool CPlayerManager::OnClientConnected(CPlayerSlot slot, uint64 xuid, const char* pszNetworkID)
@@ -790,6 +801,7 @@ bool CPlayerManager::OnClientConnected(CPlayerSlot slot, uint64 xuid, const char
 
 	pPlayer->SetConnected();
 	m_vecPlayers[slot.Get()] = pPlayer;
+	m_iConnectedMask |= 1ull << slot.Get();
 
 	ResetPlayerFlags(slot.Get());
 
@@ -816,9 +828,17 @@ void CPlayerManager::OnClientDisconnect(CPlayerSlot slot)
 	if (g_cvarEnableEntWatch.Get())
 		EW_PlayerDisconnect(slot.Get());
 
+	if (m_vecPlayers[slot.Get()] && m_vecPlayers[slot.Get()]->IsAuthenticated())
+		m_steamIdIndex.Remove(m_vecPlayers[slot.Get()]->GetSteamId64(), slot.Get());
+
 	delete m_vecPlayers[slot.Get()];
 	m_vecPlayers[slot.Get()] = nullptr;
 
+	uint64 iClearMask = ~(1ull << slot.Get());
+	m_iConnectedMask &= iClearMask;
+	m_iInGameMask &= iClearMask;
+	m_iFakeClientMask &= iClearMask;
+
 	ResetPlayerFlags(slot.Get());
 
 	g_pMapVoteSystem->ClearPlayerInfo(slot.Get());
@@ -838,6 +858,7 @@ void CPlayerManager::OnClientPutInServer(CPlayerSlot slot)
 	ZEPlayer* pPlayer = m_vecPlayers[slot.Get()];
 
 	pPlayer->SetInGame(true);
+	m_iInGameMask |= 1ull << slot.Get();
 
 	if (!g_pSpawnGroupMgr)
 		return;
@@ -933,19 +954,83 @@ void CPlayerManager::CheckInfractions()
 	if (!GetGlobals())
 		return;
 
-	for (int i = 0; i < GetGlobals()->maxClients; i++)
-	{
-		if (m_vecPlayers[i] == nullptr || m_vecPlayers[i]->IsFakeClient())
-			continue;
-
+	for (int i : PlayerBits(m_iConnectedMask & ~m_iFakeClientMask))
 		m_vecPlayers[i]->CheckInfractions();
-	}
 
 	g_pAdminSystem->SaveInfractions();
 }
 
 CConVar<bool> g_cvarFlashLightEnable("cs2f_flashlight_enable", FCVAR_NONE, "Whether to enable flashlights", false);
 
+void CPlayerManager::UpdateSnapshot()
+{
+	if (!g_pEntitySystem || !GetGlobals())
+		return;
+
+	VPROF("CPlayerManager::UpdateSnapshot");
+
+	int iMaxClients = MIN(GetGlobals()->maxClients, MAXPLAYERS);
+
+	for (int i = 0; i < MAXPLAYERS; i++)
+	{
+		PlayerSnapshot_t& player = m_snapshot[i];
+		player = {};
+
+		CCSPlayerController* pController = i < iMaxClients ? CCSPlayerController::FromSlot(i) : nullptr;
+
+		if (!pController)
+			continue;
+
+		player.pController = pController;
+		player.iTeam = pController->m_iTeamNum;
+		player.bPawnIsAlive = pController->m_bPawnIsAlive;
+		player.pPlayerPawn = pController->GetPlayerPawn();
+
+		CBasePlayerPawn* pPawn = pController->GetPawn();
+
+		if (!pPawn)
+			continue;
+
+		player.pPawn = pPawn;
+		player.vecOrigin = pPawn->GetAbsOrigin();
+		player.bAlive = pPawn->IsAlive();
+
+		if (pPawn->m_pMovementServices())
+		{
+			uint64* pButtons = pPawn->m_pMovementServices->m_nButtons().m_pButtonStates();
+
+			player.bHasButtons = true;
+			player.iButtons[0] = pButtons[0];
+			player.iButtons[1] = pButtons[1];
+		}
+	}
+}
+
+void CPlayerManager::OnEntityDeleted(CEntityInstance* pEntity)
+{
+	for (int i = 0; i < MAXPLAYERS; i++)
+	{
+		PlayerSnapshot_t& player = m_snapshot[i];
+
+		if (player.pController == pEntity)
+		{
+			player = {};
+			continue;
+		}
+
+		if (player.pPlayerPawn == pEntity)
+			player.pPlayerPawn = nullptr;
+
+		if (player.pPawn == pEntity)
+		{
+			player.pPawn = nullptr;
+			player.bAlive = false;
+			player.bHasButtons = false;
+			player.iButtons[0] = player.iButtons[1] = 0;
+		}
+	}
+}
+
 void CPlayerManager::FlashLightThink()
 {
 	if (!g_cvarFlashLightEnable.Get() || !GetGlobals())
@@ -955,29 +1040,52 @@ void CPlayerManager::FlashLightThink()
 
 	for (int i = 0; i < GetGlobals()->maxClients; i++)
 	{
-		CCSPlayerController* pPlayer = CCSPlayerController::FromSlot(i);
+		const PlayerSnapshot_t* pSnapshot = GetSnapshot(i);
 
-		if (!pPlayer || !pPlayer->m_bPawnIsAlive())
+		if (!pSnapshot || !pSnapshot->bPawnIsAlive)
 			continue;
-		auto pawn = pPlayer->GetPawn();
+		auto pawn = pSnapshot->pPawn;
 		if (!pawn || pawn->m_iHealth < 1) {
 			continue;
 		}
-		const auto pMovement = pawn->m_pMovementServices();
-		if (!pMovement) {
+		if (!pSnapshot->bHasButtons) {
 			continue;
 		}
-		uint64* pButtons = pPlayer->GetPawn()->m_pMovementServices->m_nButtons().m_pButtonStates();
 
 		// Check both to make sure flashlight is only toggled when the player presses the key
-		if ((pButtons[0] & IN_LOOK_AT_WEAPON) && (pButtons[1] & IN_LOOK_AT_WEAPON))
-			pPlayer->GetZEPlayer()->ToggleFlashLight();
+		if ((pSnapshot->iButtons[0] & IN_LOOK_AT_WEAPON) && (pSnapshot->iButtons[1] & IN_LOOK_AT_WEAPON))
+			pSnapshot->pController->GetZEPlayer()->ToggleFlashLight();
 	}
 }
 
 CConVar<bool> g_cvarHideTeammatesOnly("cs2f_hide_teammates_only", FCVAR_NONE, "Whether to hide teammates only", false);
 
 extern CConVar<bool> g_cvarEnableHide;
+extern double g_flUniversalTime;
+
+// Pawn origins of the last hide check, bucketed by a cell size in the range of typical hide distances
+static CSpatialGrid g_hideGrid(512.0f);
+
+CConVar<float> g_cvarHideHysteresis("cs2f_hide_hysteresis", FCVAR_NONE, "How far past their hide distance a hidden player has to move before being shown again, 0 to show them as soon as they leave it", 0.0f, true, 0.0f, false, 0.0f);
+CConVar<float> g_cvarHideMinHoldTime("cs2f_hide_min_hold_time", FCVAR_NONE, "Minimum amount of seconds a player stays hidden or shown before hide distance can change it again, 0 to change it on every check", 0.0f, true, 0.0f, false, 0.0f);
+
+// Distance based hide decisions of the last check, and when each one last changed
+static uint64 g_iHideDecisions[MAXPLAYERS];
+static double g_flHideDecisionTime[MAXPLAYERS][MAXPLAYERS];
+
+void ResetHideDecisions(int iSlot)
+{
+	g_iHideDecisions[iSlot] = 0;
+
+	for (int i = 0; i < MAXPLAYERS; i++)
+	{
+		g_iHideDecisions[i] &= ~(1ull << iSlot);
+
+		// Far enough in the past that the hold time never delays the first decision
+		g_flHideDecisionTime[iSlot][i] = -DBL_MAX;
+		g_flHideDecisionTime[i][iSlot] = -DBL_MAX;
+	}
+}
 
 void CPlayerManager::CheckHideDistances()
 {
@@ -986,51 +1094,104 @@ void CPlayerManager::CheckHideDistances()
 
 	VPROF("CPlayerManager::CheckHideDistances");
 
-	for (int i = 0; i < GetGlobals()->maxClients; i++)
+	Vector vecPositions[MAXPLAYERS];
+	float flHideDistance[MAXPLAYERS];
+	int iTeams[MAXPLAYERS];
+	uint64 iPawnMask = 0;
+	int iMaxClients = MIN(GetGlobals()->maxClients, MAXPLAYERS);
+
+	g_hideGrid.Clear();
+
+	for (int i = 0; i < iMaxClients; i++)
 	{
+		// Players that don't hide anyone only get their position used
+		flHideDistance[i] = -1.0f;
+
 		auto player = GetPlayer(i);
 
-		if (!player)
+		if (player)
+			player->ClearTransmit();
+
+		const PlayerSnapshot_t* pSnapshot = GetSnapshot(i);
+
+		// TODO: Unhide dead pawns if/when valve fixes the crash
+		if (!pSnapshot || !pSnapshot->pPawn)
+			continue;
+
+		vecPositions[i] = pSnapshot->vecOrigin;
+		iTeams[i] = pSnapshot->iTeam;
+		iPawnMask |= 1ull << i;
+		g_hideGrid.Add(i, vecPositions[i]);
+
+		if (!player || !pSnapshot->bAlive)
 			continue;
 
-		player->ClearTransmit();
 		auto hideDistance = player->GetHideDistance();
 
 		if (!hideDistance || !g_cvarEnableHide.Get())
 			continue;
 
-		CCSPlayerController* pController = CCSPlayerController::FromSlot(i);
+		player->SetHoldingRMB(pSnapshot->iButtons[0] & IN_ATTACK2);
 
-		if (!pController)
-			continue;
+		flHideDistance[i] = hideDistance;
+	}
+
+	g_hideGrid.Build();
 
-		auto pPawn = pController->GetPawn();
+	bool bTeammatesOnly = g_cvarHideTeammatesOnly.Get();
+	float flHysteresis = g_cvarHideHysteresis.Get();
+	float flMinHoldTime = g_cvarHideMinHoldTime.Get();
 
-		if (!pPawn || !pPawn->IsAlive())
+	for (int i = 0; i < iMaxClients; i++)
+	{
+		if (flHideDistance[i] < 0.0f)
+		{
+			g_iHideDecisions[i] = 0;
 			continue;
+		}
+
+		float flHideDistanceSqr = flHideDistance[i] * flHideDistance[i];
+		uint64 iInside = 0;
+		uint64 iInsideBand = 0;
 
-		uint64* pButtons = pPawn->m_pMovementServices->m_nButtons().m_pButtonStates();
-		player->HoldingRMB = pButtons[0] & IN_ATTACK2;
+		g_hideGrid.ForEachInRange(vecPositions[i], flHideDistance[i] + flHysteresis, [&](int j, float flDistSqr) {
+			iInsideBand |= 1ull << j;
+
+			if (flDistSqr <= flHideDistanceSqr)
+				iInside |= 1ull << j;
+		});
 
-		auto vecPosition = pPawn->GetAbsOrigin();
-		int team = pController->m_iTeamNum;
+		// Players get hidden once inside the hide distance, but only shown again once they leave the band past it
+		uint64 iPrevious = g_iHideDecisions[i];
+		uint64 iDecision = iInside | (iPrevious & iInsideBand);
 
-		for (int j = 0; j < GetGlobals()->maxClients; j++)
+		// Changing a decision that was made too recently has to wait for a later check
+		for (uint64 iBits = iDecision ^ iPrevious; iBits; iBits &= iBits - 1)
 		{
-			if (j == i)
-				continue;
+			int j = std::countr_zero(iBits);
+
+			if (g_flUniversalTime - g_flHideDecisionTime[i][j] < flMinHoldTime)
+				iDecision ^= 1ull << j;
+			else
+				g_flHideDecisionTime[i][j] = g_flUniversalTime;
+		}
 
-			CCSPlayerController* pTargetController = CCSPlayerController::FromSlot(j);
+		g_iHideDecisions[i] = iDecision;
 
-			if (pTargetController)
+		uint64 iHidden = iDecision & iPawnMask & ~(1ull << i);
+
+		if (bTeammatesOnly)
+		{
+			for (uint64 iBits = iHidden; iBits; iBits &= iBits - 1)
 			{
-				auto pTargetPawn = pTargetController->GetPawn();
+				int j = std::countr_zero(iBits);
 
-				// TODO: Unhide dead pawns if/when valve fixes the crash
-				if (pTargetPawn && (!g_cvarHideTeammatesOnly.Get() || pTargetController->m_iTeamNum == team))
-					player->SetTransmit(j, pTargetPawn->GetAbsOrigin().DistToSqr(vecPosition) <= hideDistance * hideDistance);
+				if (iTeams[j] != iTeams[i])
+					iHidden &= ~(1ull << j);
 			}
 		}
+
+		GetPlayer(i)->SetTransmitMask(iHidden);
 	}
 }
 
@@ -1051,18 +1212,15 @@ void CPlayerManager::UpdatePlayerStates()
 	if (!GetGlobals())
 		return;
 
-	for (int i = 0; i < GetGlobals()->maxClients; i++)
+	for (int i : PlayerBits(m_iConnectedMask))
 	{
-		ZEPlayer* pPlayer = GetPlayer(i);
+		ZEPlayer* pPlayer = m_vecPlayers[i];
+		const PlayerSnapshot_t* pSnapshot = GetSnapshot(i);
 
-		if (!pPlayer)
-			continue;
-
-		CCSPlayerController* pController = CCSPlayerController::FromSlot(i);
-
-		if (!pController)
+		if (!pSnapshot)
 			continue;
 
+		CCSPlayerController* pController = pSnapshot->pController;
 		uint32 iPreviousPlayerState = pPlayer->GetPlayerState();
 		uint32 iCurrentPlayerState = pController->GetPawnState();
 
@@ -1097,12 +1255,12 @@ void CPlayerManager::SetupInfiniteAmmo()
 
 		for (int i = 0; i < GetGlobals()->maxClients; i++)
 		{
-			CCSPlayerController* pController = CCSPlayerController::FromSlot(i);
+			const PlayerSnapshot_t* pSnapshot = g_playerManager->GetSnapshot(i);
 
-			if (!pController)
+			if (!pSnapshot)
 				continue;
 
-			auto pPawn = pController->GetPawn();
+			auto pPawn = pSnapshot->pPawn;
 
 			if (!pPawn)
 				continue;
@@ -1174,403 +1332,330 @@ ETargetError GetTargetError(CCSPlayerController* pPlayer, CCSPlayerController* p
 	return ETargetError::NO_ERRORS;
 }
 
-ETargetError CPlayerManager::GetPlayersFromString(CCSPlayerController* pPlayer, const char* pszTarget,
-												  int& iNumClients, int* rgiClients, uint64 iBlockedFlags,
-												  ETargetType& nType)
+// What a target string resolves to, see CompileTarget
+enum class ETargetSelector
 {
-	if (!GetGlobals())
-		return ETargetError::INVALID;
-
-	nType = ETargetType::NONE;
-	ZEPlayer* zpPlayer = pPlayer ? pPlayer->GetZEPlayer() : nullptr;
-	bool bTargetMultiple = false;
-	bool bTargetRandom = false;
-	uint64 iInverseFlags = NO_TARGET_BLOCKS;
+	INVALID,
+	SELF,
+	MULTIPLE,
+	RANDOM,
+	ALL_BUT_RANDOM,
+	AIM,
+	ALL_BUT_AIM,
+	USERID,
+	STEAMID,
+	NAME,
+};
 
-	if (!V_stricmp(pszTarget, "@me"))
-	{
-		nType = ETargetType::SELF;
+// A target string parsed once into the checks and flags it applies, so running it again
+// only has to walk the player masks
+struct CompiledTarget_t
+{
+	ETargetSelector nSelector = ETargetSelector::NAME;
+	ETargetType nType = ETargetType::NONE;
 
-		if (iBlockedFlags & NO_SELF || !pPlayer)
-			return ETargetError::SELF;
-	}
-	else if (!V_stricmp(pszTarget, "@!me"))
+	// Errors to return up front if the caller blocks these flags, in order
+	struct
 	{
-		nType = ETargetType::ALL_BUT_SELF;
+		uint64 iBlockedFlag;
+		ETargetError eError;
+	} checks[3];
+	int nChecks = 0;
+
+	uint64 iAddBlockedFlags = NO_TARGET_BLOCKS;
+	uint64 iInverseFlags = NO_TARGET_BLOCKS; // Who can be picked as the excluded player of ALL_BUT_RANDOM
+
+	int iUserID = -1;
+	uint64 iSteamID = -1;
+	bool bExactName = false;
+	std::string strName; // Lowercase unless bExactName
+};
 
-		if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
+struct TargetSelectorDef_t
+{
+	const char* pszSelector;
+	ETargetSelector nSelector;
+	ETargetType nType;
+	uint64 iCheckFlags[3];
+	ETargetError eCheckErrors[3];
+	uint64 iAddBlockedFlags;
+	uint64 iInverseFlags;
+};
 
-		iBlockedFlags |= NO_SELF;
-		bTargetMultiple = true;
-	}
-	else if (!V_stricmp(pszTarget, "@all"))
-	{
-		nType = ETargetType::ALL;
+static const TargetSelectorDef_t g_targetSelectors[] = {
+	{"@me", ETargetSelector::SELF, ETargetType::SELF, {NO_SELF}, {ETargetError::SELF}},
+	{"@!me", ETargetSelector::MULTIPLE, ETargetType::ALL_BUT_SELF, {NO_MULTIPLE}, {ETargetError::MULTIPLE}, NO_SELF},
+	{"@all", ETargetSelector::MULTIPLE, ETargetType::ALL, {NO_MULTIPLE}, {ETargetError::MULTIPLE}},
+	{"@!all", ETargetSelector::INVALID, ETargetType::NONE},
+	{"@t", ETargetSelector::MULTIPLE, ETargetType::T, {NO_TERRORIST, NO_MULTIPLE}, {ETargetError::TERRORIST, ETargetError::MULTIPLE}, NO_COUNTER_TERRORIST | NO_SPECTATOR},
+	{"@!t", ETargetSelector::MULTIPLE, ETargetType::ALL_BUT_T, {NO_MULTIPLE}, {ETargetError::MULTIPLE}, NO_TERRORIST},
+	{"@ct", ETargetSelector::MULTIPLE, ETargetType::CT, {NO_COUNTER_TERRORIST, NO_MULTIPLE}, {ETargetError::COUNTER_TERRORIST, ETargetError::MULTIPLE}, NO_TERRORIST | NO_SPECTATOR},
+	{"@!ct", ETargetSelector::MULTIPLE, ETargetType::ALL_BUT_CT, {NO_MULTIPLE}, {ETargetError::MULTIPLE}, NO_COUNTER_TERRORIST},
+	{"@spec", ETargetSelector::MULTIPLE, ETargetType::SPECTATOR, {NO_SPECTATOR, NO_DEAD, NO_MULTIPLE}, {ETargetError::SPECTATOR, ETargetError::DEAD, ETargetError::MULTIPLE}, NO_TERRORIST | NO_COUNTER_TERRORIST},
+	{"@!spec", ETargetSelector::MULTIPLE, ETargetType::ALL_BUT_SPECTATOR, {NO_MULTIPLE}, {ETargetError::MULTIPLE}, NO_SPECTATOR},
+	{"@random", ETargetSelector::RANDOM, ETargetType::RANDOM, {NO_RANDOM}, {ETargetError::RANDOM}},
+	{"@!random", ETargetSelector::ALL_BUT_RANDOM, ETargetType::ALL_BUT_RANDOM, {NO_RANDOM}, {ETargetError::RANDOM}, NO_TARGET_BLOCKS, NO_RANDOM},
+	{"@randomt", ETargetSelector::RANDOM, ETargetType::RANDOM_T, {NO_TERRORIST, NO_RANDOM}, {ETargetError::TERRORIST, ETargetError::RANDOM}, NO_COUNTER_TERRORIST},
+	{"@!randomt", ETargetSelector::ALL_BUT_RANDOM, ETargetType::ALL_BUT_RANDOM_T, {NO_RANDOM}, {ETargetError::RANDOM}, NO_TARGET_BLOCKS, NO_RANDOM | NO_COUNTER_TERRORIST | NO_SPECTATOR},
+	{"@randomct", ETargetSelector::RANDOM, ETargetType::RANDOM_CT, {NO_COUNTER_TERRORIST, NO_RANDOM}, {ETargetError::COUNTER_TERRORIST, ETargetError::RANDOM}, NO_TERRORIST},
+	{"@!randomct", ETargetSelector::ALL_BUT_RANDOM, ETargetType::RANDOM_CT, {NO_RANDOM}, {ETargetError::RANDOM}, NO_TARGET_BLOCKS, NO_RANDOM | NO_TERRORIST | NO_SPECTATOR},
+	{"@randomspec", ETargetSelector::RANDOM, ETargetType::RANDOM_SPEC, {NO_SPECTATOR, NO_DEAD, NO_RANDOM}, {ETargetError::SPECTATOR, ETargetError::DEAD, ETargetError::RANDOM}, NO_TERRORIST | NO_COUNTER_TERRORIST},
+	{"@!randomspec", ETargetSelector::ALL_BUT_RANDOM, ETargetType::ALL_BUT_RANDOM_SPEC, {NO_RANDOM}, {ETargetError::RANDOM}, NO_TARGET_BLOCKS, NO_RANDOM | NO_TERRORIST | NO_COUNTER_TERRORIST},
+	{"@dead", ETargetSelector::MULTIPLE, ETargetType::DEAD, {NO_DEAD, NO_MULTIPLE}, {ETargetError::DEAD, ETargetError::MULTIPLE}, NO_ALIVE},
+	{"@!alive", ETargetSelector::MULTIPLE, ETargetType::DEAD, {NO_DEAD, NO_MULTIPLE}, {ETargetError::DEAD, ETargetError::MULTIPLE}, NO_ALIVE},
+	{"@alive", ETargetSelector::MULTIPLE, ETargetType::ALIVE, {NO_ALIVE, NO_MULTIPLE}, {ETargetError::ALIVE, ETargetError::MULTIPLE}, NO_DEAD},
+	{"@!dead", ETargetSelector::MULTIPLE, ETargetType::ALIVE, {NO_ALIVE, NO_MULTIPLE}, {ETargetError::ALIVE, ETargetError::MULTIPLE}, NO_DEAD},
+	{"@bot", ETargetSelector::MULTIPLE, ETargetType::BOT, {NO_BOT, NO_MULTIPLE}, {ETargetError::BOT, ETargetError::MULTIPLE}, NO_HUMAN},
+	{"@!human", ETargetSelector::MULTIPLE, ETargetType::BOT, {NO_BOT, NO_MULTIPLE}, {ETargetError::BOT, ETargetError::MULTIPLE}, NO_HUMAN},
+	{"@human", ETargetSelector::MULTIPLE, ETargetType::HUMAN, {NO_HUMAN, NO_MULTIPLE}, {ETargetError::HUMAN, ETargetError::MULTIPLE}, NO_BOT},
+	{"@!bot", ETargetSelector::MULTIPLE, ETargetType::HUMAN, {NO_HUMAN, NO_MULTIPLE}, {ETargetError::HUMAN, ETargetError::MULTIPLE}, NO_BOT},
+	{"@aim", ETargetSelector::AIM, ETargetType::NONE},
+	{"@!aim", ETargetSelector::ALL_BUT_AIM, ETargetType::NONE},
+};
 
-		if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
+// Same folding as V_stristr, only ASCII letters are affected so UTF-8 names are left intact
+static void LowercaseName(std::string& strName)
+{
+	for (char& c : strName)
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+}
 
-		bTargetMultiple = true;
-	}
-	else if (!V_stricmp(pszTarget, "@!all"))
-		return ETargetError::INVALID;
-	else if (!V_stricmp(pszTarget, "@t"))
+static void CompileTarget(const char* pszTarget, CompiledTarget_t& target)
+{
+	for (const TargetSelectorDef_t& def : g_targetSelectors)
 	{
-		nType = ETargetType::T;
-
-		if (iBlockedFlags & NO_TERRORIST)
-			return ETargetError::TERRORIST;
-		else if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
+		if (V_stricmp(pszTarget, def.pszSelector))
+			continue;
 
-		bTargetMultiple = true;
-		iBlockedFlags |= NO_COUNTER_TERRORIST | NO_SPECTATOR;
-	}
-	else if (!V_stricmp(pszTarget, "@!t"))
-	{
-		nType = ETargetType::ALL_BUT_T;
+		target.nSelector = def.nSelector;
+		target.nType = def.nType;
+		target.iAddBlockedFlags = def.iAddBlockedFlags;
+		target.iInverseFlags = def.iInverseFlags;
 
-		if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
+		for (int i = 0; i < 3 && def.iCheckFlags[i]; i++)
+			target.checks[target.nChecks++] = {def.iCheckFlags[i], def.eCheckErrors[i]};
 
-		bTargetMultiple = true;
-		iBlockedFlags |= NO_TERRORIST;
+		return;
 	}
-	else if (!V_stricmp(pszTarget, "@ct"))
-	{
-		nType = ETargetType::CT;
-
-		if (iBlockedFlags & NO_COUNTER_TERRORIST)
-			return ETargetError::COUNTER_TERRORIST;
-		else if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
 
-		bTargetMultiple = true;
-		iBlockedFlags |= NO_TERRORIST | NO_SPECTATOR;
-	}
-	else if (!V_stricmp(pszTarget, "@!ct"))
+	if (*pszTarget == '#')
 	{
-		nType = ETargetType::ALL_BUT_CT;
-
-		if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
-
-		bTargetMultiple = true;
-		iBlockedFlags |= NO_COUNTER_TERRORIST;
+		target.nSelector = ETargetSelector::USERID;
+		target.iUserID = V_StringToUint16(pszTarget + 1, -1);
 	}
-	else if (!V_stricmp(pszTarget, "@spec"))
+	else if (*pszTarget == '$')
 	{
-		nType = ETargetType::SPECTATOR;
-
-		if (iBlockedFlags & NO_SPECTATOR)
-			return ETargetError::SPECTATOR;
-		else if (iBlockedFlags & NO_DEAD)
-			return ETargetError::DEAD;
-		else if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
-
-		bTargetMultiple = true;
-		iBlockedFlags |= NO_TERRORIST | NO_COUNTER_TERRORIST;
+		target.nSelector = ETargetSelector::STEAMID;
+		target.iSteamID = V_StringToUint64(pszTarget + 1, -1);
 	}
-	else if (!V_stricmp(pszTarget, "@!spec"))
+	else
 	{
-		nType = ETargetType::ALL_BUT_SPECTATOR;
+		target.bExactName = (*pszTarget == '&');
+		target.strName = target.bExactName ? pszTarget + 1 : pszTarget;
 
-		if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
-
-		bTargetMultiple = true;
-		iBlockedFlags |= NO_SPECTATOR;
+		if (!target.bExactName)
+			LowercaseName(target.strName);
 	}
-	else if (!V_stricmp(pszTarget, "@random"))
-	{
-		nType = ETargetType::RANDOM;
+}
 
-		if (iBlockedFlags & NO_RANDOM)
-			return ETargetError::RANDOM;
+#define TARGET_CACHE_SIZE 64
 
-		bTargetRandom = true;
-	}
-	else if (!V_stricmp(pszTarget, "@!random"))
-	{
-		nType = ETargetType::ALL_BUT_RANDOM;
+// Most recently used compiled targets, admins tend to reuse the same few
+static std::list<std::pair<std::string, CompiledTarget_t>> g_targetCache;
+static std::unordered_map<std::string, decltype(g_targetCache)::iterator> g_targetCacheMap;
 
-		if (iBlockedFlags & NO_RANDOM)
-			return ETargetError::RANDOM;
+static const CompiledTarget_t& GetCompiledTarget(const char* pszTarget)
+{
+	auto it = g_targetCacheMap.find(pszTarget);
 
-		iInverseFlags = NO_RANDOM;
-	}
-	else if (!V_stricmp(pszTarget, "@randomt"))
+	if (it != g_targetCacheMap.end())
 	{
-		nType = ETargetType::RANDOM_T;
-
-		if (iBlockedFlags & NO_TERRORIST)
-			return ETargetError::TERRORIST;
-		else if (iBlockedFlags & NO_RANDOM)
-			return ETargetError::RANDOM;
-
-		bTargetRandom = true;
-		iBlockedFlags |= NO_COUNTER_TERRORIST;
+		g_targetCache.splice(g_targetCache.begin(), g_targetCache, it->second);
+		return it->second->second;
 	}
-	else if (!V_stricmp(pszTarget, "@!randomt"))
-	{
-		nType = ETargetType::ALL_BUT_RANDOM_T;
-
-		if (iBlockedFlags & NO_RANDOM)
-			return ETargetError::RANDOM;
 
-		iInverseFlags = NO_RANDOM | NO_COUNTER_TERRORIST | NO_SPECTATOR;
-	}
-	else if (!V_stricmp(pszTarget, "@randomct"))
+	if (g_targetCache.size() >= TARGET_CACHE_SIZE)
 	{
-		nType = ETargetType::RANDOM_CT;
+		g_targetCacheMap.erase(g_targetCache.back().first);
+		g_targetCache.pop_back();
+	}
 
-		if (iBlockedFlags & NO_COUNTER_TERRORIST)
-			return ETargetError::COUNTER_TERRORIST;
-		else if (iBlockedFlags & NO_RANDOM)
-			return ETargetError::RANDOM;
+	g_targetCache.emplace_front(pszTarget, CompiledTarget_t());
+	CompileTarget(pszTarget, g_targetCache.front().second);
+	g_targetCacheMap[pszTarget] = g_targetCache.begin();
 
-		bTargetRandom = true;
-		iBlockedFlags |= NO_TERRORIST;
-	}
-	else if (!V_stricmp(pszTarget, "@!randomct"))
-	{
-		nType = ETargetType::RANDOM_CT;
+	return g_targetCache.front().second;
+}
 
-		if (iBlockedFlags & NO_RANDOM)
-			return ETargetError::RANDOM;
+// Lowercase copies of player names for substring targetting, rebuilt whenever a name no longer matches
+static struct
+{
+	std::string strName;
+	std::string strLower;
+} g_targetNameIndex[MAXPLAYERS];
 
-		iInverseFlags = NO_RANDOM | NO_TERRORIST | NO_SPECTATOR;
-	}
-	else if (!V_stricmp(pszTarget, "@randomspec"))
+static const std::string& GetLowercaseName(int iSlot, const char* pszName)
+{
+	auto& entry = g_targetNameIndex[iSlot];
+
+	if (entry.strName != pszName)
 	{
-		nType = ETargetType::RANDOM_SPEC;
+		entry.strName = pszName;
+		entry.strLower = pszName;
+		LowercaseName(entry.strLower);
+	}
 
-		if (iBlockedFlags & NO_SPECTATOR)
-			return ETargetError::SPECTATOR;
-		else if (iBlockedFlags & NO_DEAD)
-			return ETargetError::DEAD;
-		else if (iBlockedFlags & NO_RANDOM)
-			return ETargetError::RANDOM;
+	return entry.strLower;
+}
 
-		bTargetRandom = true;
-		iBlockedFlags |= NO_TERRORIST | NO_COUNTER_TERRORIST;
-	}
-	else if (!V_stricmp(pszTarget, "@!randomspec"))
-	{
-		nType = ETargetType::ALL_BUT_RANDOM_SPEC;
+// Narrows down who can pass GetTargetError with these flags, every candidate still has to be checked.
+// Only the bot flags are applied here, team and alive state is left to the live checks in GetTargetError
+uint64 CPlayerManager::GetTargetCandidates(uint64 iBlockedFlags)
+{
+	uint64 iCandidates = m_iConnectedMask;
 
-		if (iBlockedFlags & NO_RANDOM)
-			return ETargetError::RANDOM;
+	if (iBlockedFlags & NO_BOT)
+		iCandidates &= ~m_iFakeClientMask;
+	if (iBlockedFlags & NO_HUMAN)
+		iCandidates &= m_iFakeClientMask;
 
-		iInverseFlags = NO_RANDOM | NO_TERRORIST | NO_COUNTER_TERRORIST;
-	}
-	else if (!V_stricmp(pszTarget, "@dead") || !V_stricmp(pszTarget, "@!alive"))
-	{
-		nType = ETargetType::DEAD;
+	return iCandidates;
+}
 
-		if (iBlockedFlags & NO_DEAD)
-			return ETargetError::DEAD;
-		if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
+// Picks a random slot out of the candidates that pass GetTargetError, -1 if none do
+int CPlayerManager::GetRandomTarget(CCSPlayerController* pPlayer, uint64 iBlockedFlags)
+{
+	int rgiValid[MAXPLAYERS];
+	int nValid = 0;
 
-		bTargetMultiple = true;
-		iBlockedFlags |= NO_ALIVE;
-	}
-	else if (!V_stricmp(pszTarget, "@alive") || !V_stricmp(pszTarget, "@!dead"))
-	{
-		nType = ETargetType::ALIVE;
+	for (int i : PlayerBits(GetTargetCandidates(iBlockedFlags)))
+		if (GetTargetError(pPlayer, CCSPlayerController::FromSlot(i), iBlockedFlags) == ETargetError::NO_ERRORS)
+			rgiValid[nValid++] = i;
 
-		if (iBlockedFlags & NO_ALIVE)
-			return ETargetError::ALIVE;
-		if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
+	return nValid ? rgiValid[rand() % nValid] : -1;
+}
 
-		bTargetMultiple = true;
-		iBlockedFlags |= NO_DEAD;
-	}
-	else if (!V_stricmp(pszTarget, "@bot") || !V_stricmp(pszTarget, "@!human"))
-	{
-		nType = ETargetType::BOT;
+ETargetError CPlayerManager::GetPlayersFromString(CCSPlayerController* pPlayer, const char* pszTarget,
+												  int& iNumClients, int* rgiClients, uint64 iBlockedFlags,
+												  ETargetType& nType)
+{
+	if (!GetGlobals())
+		return ETargetError::INVALID;
 
-		if (iBlockedFlags & NO_BOT)
-			return ETargetError::BOT;
-		if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
+	const CompiledTarget_t& target = GetCompiledTarget(pszTarget);
 
-		bTargetMultiple = true;
-		iBlockedFlags |= NO_HUMAN;
-	}
-	else if (!V_stricmp(pszTarget, "@human") || !V_stricmp(pszTarget, "@!bot"))
-	{
-		nType = ETargetType::HUMAN;
+	nType = target.nType;
 
-		if (iBlockedFlags & NO_HUMAN)
-			return ETargetError::HUMAN;
-		if (iBlockedFlags & NO_MULTIPLE)
-			return ETargetError::MULTIPLE;
+	if (target.nSelector == ETargetSelector::INVALID)
+		return ETargetError::INVALID;
 
-		bTargetMultiple = true;
-		iBlockedFlags |= NO_BOT;
-	}
+	for (int i = 0; i < target.nChecks; i++)
+		if (iBlockedFlags & target.checks[i].iBlockedFlag)
+			return target.checks[i].eError;
 
-	// We have setup what we need and given custom errors if needed for group targetting.
-	// Now we actually get the target(s).
-	if (nType == ETargetType::SELF)
-	{
-		ETargetError eType = GetTargetError(pPlayer, pPlayer, iBlockedFlags);
-		if (eType != ETargetError::NO_ERRORS)
-			return eType;
+	iBlockedFlags |= target.iAddBlockedFlags;
 
-		rgiClients[iNumClients++] = zpPlayer->GetPlayerSlot().Get();
-		return ETargetError::NO_ERRORS;
-	}
-	else if (bTargetMultiple)
+	switch (target.nSelector)
 	{
-		for (int i = 0; i < GetGlobals()->maxClients; i++)
+		case ETargetSelector::SELF:
 		{
-			if (m_vecPlayers[i] == nullptr)
-				continue;
+			if (!pPlayer)
+				return ETargetError::SELF;
 
-			CCSPlayerController* pTarget = CCSPlayerController::FromSlot(i);
+			ETargetError eType = GetTargetError(pPlayer, pPlayer, iBlockedFlags);
+			if (eType != ETargetError::NO_ERRORS)
+				return eType;
 
-			if (GetTargetError(pPlayer, pTarget, iBlockedFlags) == ETargetError::NO_ERRORS)
-				rgiClients[iNumClients++] = i;
+			rgiClients[iNumClients++] = pPlayer->GetPlayerSlot();
+			return ETargetError::NO_ERRORS;
 		}
-	}
-	else if (bTargetRandom)
-	{
-		int iAttempts = 0;
-
-		while (iNumClients == 0 && iAttempts < 10000)
+		case ETargetSelector::MULTIPLE:
 		{
-			int iSlot = rand() % (GetGlobals()->maxClients - 1);
-
-			// Prevent infinite loop
-			iAttempts++;
-
-			if (m_vecPlayers[iSlot] == nullptr)
-				continue;
-
-			CCSPlayerController* pTarget = CCSPlayerController::FromSlot(iSlot);
-			if (GetTargetError(pPlayer, pTarget, iBlockedFlags) == ETargetError::NO_ERRORS)
-			{
-				rgiClients[iNumClients++] = iSlot;
-				break;
-			}
+			for (int i : PlayerBits(GetTargetCandidates(iBlockedFlags)))
+				if (GetTargetError(pPlayer, CCSPlayerController::FromSlot(i), iBlockedFlags) == ETargetError::NO_ERRORS)
+					rgiClients[iNumClients++] = i;
+			break;
 		}
-	}
-	else if (iInverseFlags > NO_TARGET_BLOCKS)
-	{
-		CCSPlayerController* pRandomPlayer = nullptr;
-		int iAttempts = 0;
-
-		while (iNumClients == 0 && iAttempts < 10000)
+		case ETargetSelector::RANDOM:
 		{
-			int iSlot = rand() % (GetGlobals()->maxClients - 1);
+			int iSlot = GetRandomTarget(pPlayer, iBlockedFlags);
 
-			// Prevent infinite loop
-			iAttempts++;
-
-			if (m_vecPlayers[iSlot] == nullptr)
-				continue;
-
-			CCSPlayerController* pTarget = CCSPlayerController::FromSlot(iSlot);
-
-			// Can ignore immunity and blocked flags here, since we are NOT targetting them
-			if (GetTargetError(pPlayer, pTarget, iInverseFlags | NO_IMMUNITY) == ETargetError::NO_ERRORS)
-			{
-				pRandomPlayer = pTarget;
-				break;
-			}
+			if (iSlot != -1)
+				rgiClients[iNumClients++] = iSlot;
+			break;
 		}
-
-		if (pRandomPlayer == nullptr)
-			return ETargetError::INVALID;
-
-		for (int i = 0; i < GetGlobals()->maxClients; i++)
+		case ETargetSelector::ALL_BUT_RANDOM:
 		{
-			if (m_vecPlayers[i] == nullptr)
-				continue;
+			// Can ignore immunity and blocked flags here, since we are NOT targetting them
+			int iRandomSlot = GetRandomTarget(pPlayer, target.iInverseFlags | NO_IMMUNITY);
 
-			CCSPlayerController* pTarget = CCSPlayerController::FromSlot(i);
-			if (pRandomPlayer == pTarget)
-				continue;
+			if (iRandomSlot == -1)
+				return ETargetError::INVALID;
 
-			if (GetTargetError(pPlayer, pTarget, iBlockedFlags) == ETargetError::NO_ERRORS)
-				rgiClients[iNumClients++] = i;
+			for (int i : PlayerBits(GetTargetCandidates(iBlockedFlags) & ~(1ull << iRandomSlot)))
+				if (GetTargetError(pPlayer, CCSPlayerController::FromSlot(i), iBlockedFlags) == ETargetError::NO_ERRORS)
+					rgiClients[iNumClients++] = i;
+			break;
 		}
-	}
-	else if (!V_stricmp(pszTarget, "@aim"))
-	{
-		CBaseEntity* entTarget = nullptr;
-		entTarget = UTIL_FindPickerEntity(pPlayer);
-
-		if (!entTarget || !entTarget->IsPawn())
-			return ETargetError::INVALID;
-
-		CCSPlayerController* pTarget = CCSPlayerController::FromPawn(static_cast<CCSPlayerPawn*>(entTarget));
+		case ETargetSelector::AIM:
+		{
+			CBaseEntity* entTarget = UTIL_FindPickerEntity(pPlayer);
 
-		ETargetError eType = GetTargetError(pPlayer, pTarget, iBlockedFlags);
-		if (eType != ETargetError::NO_ERRORS)
-			return eType;
+			if (!entTarget || !entTarget->IsPawn())
+				return ETargetError::INVALID;
 
-		nType = ETargetType::AIM;
+			CCSPlayerController* pTarget = CCSPlayerController::FromPawn(static_cast<CCSPlayerPawn*>(entTarget));
 
-		rgiClients[iNumClients++] = pTarget->GetPlayerSlot();
-	}
-	else if (!V_stricmp(pszTarget, "@!aim"))
-	{
-		CBaseEntity* entTarget = nullptr;
-		entTarget = UTIL_FindPickerEntity(pPlayer);
+			ETargetError eType = GetTargetError(pPlayer, pTarget, iBlockedFlags);
+			if (eType != ETargetError::NO_ERRORS)
+				return eType;
 
-		if (!entTarget || !entTarget->IsPawn())
-			return ETargetError::INVALID;
+			nType = ETargetType::AIM;
 
-		CCSPlayerController* pAimed = CCSPlayerController::FromPawn(static_cast<CCSPlayerPawn*>(entTarget));
+			rgiClients[iNumClients++] = pTarget->GetPlayerSlot();
+			break;
+		}
+		case ETargetSelector::ALL_BUT_AIM:
+		{
+			CBaseEntity* entTarget = UTIL_FindPickerEntity(pPlayer);
 
-		// Can ignore immunity and blocked flags here, since we are NOT targetting them
-		if (GetTargetError(pPlayer, pAimed, NO_IMMUNITY) != ETargetError::NO_ERRORS)
-			return ETargetError::INVALID;
+			if (!entTarget || !entTarget->IsPawn())
+				return ETargetError::INVALID;
 
-		nType = ETargetType::ALL_BUT_AIM;
+			CCSPlayerController* pAimed = CCSPlayerController::FromPawn(static_cast<CCSPlayerPawn*>(entTarget));
 
-		for (int i = 0; i < GetGlobals()->maxClients; i++)
-		{
-			if (m_vecPlayers[i] == nullptr)
-				continue;
+			// Can ignore immunity and blocked flags here, since we are NOT targetting them
+			if (GetTargetError(pPlayer, pAimed, NO_IMMUNITY) != ETargetError::NO_ERRORS)
+				return ETargetError::INVALID;
 
-			CCSPlayerController* pTarget = CCSPlayerController::FromSlot(i);
-			if (pAimed == pTarget)
-				continue;
+			nType = ETargetType::ALL_BUT_AIM;
 
-			if (GetTargetError(pPlayer, pTarget, iBlockedFlags) == ETargetError::NO_ERRORS)
-				rgiClients[iNumClients++] = i;
+			for (int i : PlayerBits(GetTargetCandidates(iBlockedFlags) & ~(1ull << pAimed->GetPlayerSlot())))
+				if (GetTargetError(pPlayer, CCSPlayerController::FromSlot(i), iBlockedFlags) == ETargetError::NO_ERRORS)
+					rgiClients[iNumClients++] = i;
+			break;
 		}
-	}
-	else if (*pszTarget == '#')
-	{
-		int iUserID = V_StringToUint16(pszTarget + 1, -1);
-
-		if (iUserID != -1)
+		case ETargetSelector::USERID:
 		{
+			if (target.iUserID == -1)
+				break;
+
 			nType = ETargetType::PLAYER;
-			CCSPlayerController* pTarget = CCSPlayerController::FromSlot(GetSlotFromUserId(iUserID).Get());
+			CCSPlayerController* pTarget = CCSPlayerController::FromSlot(GetSlotFromUserId(target.iUserID).Get());
 			ETargetError eType = GetTargetError(pPlayer, pTarget, iBlockedFlags);
 			if (eType != ETargetError::NO_ERRORS)
 				return eType;
 			rgiClients[iNumClients++] = pTarget->GetPlayerSlot();
+			break;
 		}
-	}
-	else if (*pszTarget == '$')
-	{
-		uint64 iSteamID = V_StringToUint64(pszTarget + 1, -1);
-
-		if (iSteamID != -1)
+		case ETargetSelector::STEAMID:
 		{
+			if (target.iSteamID == -1)
+				break;
+
 			nType = ETargetType::PLAYER;
-			ZEPlayer* zpTarget = GetPlayerFromSteamId(iSteamID);
+			ZEPlayer* zpTarget = GetPlayerFromSteamId(target.iSteamID);
 			if (!zpTarget)
 				return ETargetError::INVALID;
 
@@ -1580,40 +1665,38 @@ ETargetError CPlayerManager::GetPlayersFromString(CCSPlayerController* pPlayer,
 			if (eType != ETargetError::NO_ERRORS)
 				return eType;
 			rgiClients[iNumClients++] = pTarget->GetPlayerSlot();
+			break;
 		}
-	}
-	else
-	{
-		ETargetError eType = ETargetError::NO_ERRORS;
-		bool bExactName = (*pszTarget == '&');
-		if (bExactName)
-			pszTarget++;
-
-		for (int i = 0; i < GetGlobals()->maxClients; i++)
+		case ETargetSelector::NAME:
 		{
-			if (m_vecPlayers[i] == nullptr)
-				continue;
+			ETargetError eType = ETargetError::NO_ERRORS;
 
-			CCSPlayerController* pTarget = CCSPlayerController::FromSlot(i);
+			for (int i : PlayerBits(m_iConnectedMask))
+			{
+				CCSPlayerController* pTarget = CCSPlayerController::FromSlot(i);
 
-			if (!pTarget || !pTarget->IsController() || !pTarget->IsConnected() || pTarget->m_bIsHLTV)
-				continue;
+				if (!pTarget || !pTarget->IsController() || !pTarget->IsConnected() || pTarget->m_bIsHLTV)
+					continue;
 
-			if ((!bExactName && V_stristr(pTarget->GetPlayerName(), pszTarget)) || !V_strcmp(pTarget->GetPlayerName(), pszTarget))
-			{
-				nType = ETargetType::PLAYER;
-				if (iNumClients == 1)
+				const char* pszName = pTarget->GetPlayerName();
+
+				if ((!target.bExactName && GetLowercaseName(i, pszName).find(target.strName) != std::string::npos) || target.strName == pszName)
 				{
-					iNumClients = 0;
-					return ETargetError::MULTIPLE_NAME_MATCHES;
+					nType = ETargetType::PLAYER;
+					if (iNumClients == 1)
+					{
+						iNumClients = 0;
+						return ETargetError::MULTIPLE_NAME_MATCHES;
+					}
+					eType = GetTargetError(pPlayer, pTarget, iBlockedFlags);
+					if (eType == ETargetError::NO_ERRORS)
+						rgiClients[iNumClients++] = i;
 				}
-				eType = GetTargetError(pPlayer, pTarget, iBlockedFlags);
-				if (eType == ETargetError::NO_ERRORS)
-					rgiClients[iNumClients++] = i;
 			}
+			if (eType != ETargetError::NO_ERRORS)
+				return eType;
+			break;
 		}
-		if (eType != ETargetError::NO_ERRORS)
-			return eType;
 	}
 
 	return iNumClients ? ETargetError::NO_ERRORS : ETargetError::INVALID;
@@ -1734,13 +1817,102 @@ ZEPlayer* CPlayerManager::GetPlayerFromUserId(uint16 userid)
 
 ZEPlayer* CPlayerManager::GetPlayerFromSteamId(uint64 steamid)
 {
-	for (ZEPlayer* player : m_vecPlayers)
-		if (player && player->IsAuthenticated() && player->GetSteamId64() == steamid)
-			return player;
+	int iSlot = m_steamIdIndex.Find(steamid);
+
+	if (iSlot == -1)
+		return nullptr;
+
+	ZEPlayer* player = m_vecPlayers[iSlot];
+
+	// Players are indexed before they're added to m_vecPlayers, so check it's really them
+	if (player && player->IsAuthenticated() && player->GetSteamId64() == steamid)
+		return player;
 
 	return nullptr;
 }
 
+void CPlayerManager::OnPlayerAuthenticated(ZEPlayer* pPlayer)
+{
+	m_steamIdIndex.Insert(pPlayer->GetSteamId64(), pPlayer->GetPlayerSlot().Get());
+}
+
+void CSteamIdIndex::Clear()
+{
+	V_memset(m_iKeys, 0, sizeof(m_iKeys));
+	V_memset(m_iSlots, -1, sizeof(m_iSlots));
+}
+
+void CSteamIdIndex::Insert(uint64 iSteamId, int iSlot)
+{
+	if (!iSteamId)
+		return;
+
+	int i = Hash(iSteamId);
+
+	for (int n = 0; n < SIZE; n++, i = (i + 1) & (SIZE - 1))
+	{
+		// Also overwrites a stale entry for the same SteamID
+		if (!m_iKeys[i] || m_iKeys[i] == iSteamId)
+		{
+			m_iKeys[i] = iSteamId;
+			m_iSlots[i] = iSlot;
+			return;
+		}
+	}
+
+	// Only possible if entries leaked, lookups fall back to not finding the player
+	Warning("SteamID index is full, failed to add %llu\n", iSteamId);
+}
+
+void CSteamIdIndex::Remove(uint64 iSteamId, int iSlot)
+{
+	if (!iSteamId)
+		return;
+
+	int i = Hash(iSteamId);
+
+	for (int n = 0; m_iKeys[i] != iSteamId; n++, i = (i + 1) & (SIZE - 1))
+		if (!m_iKeys[i] || n == SIZE - 1)
+			return;
+
+	// Already points to the player that reconnected into another slot
+	if (m_iSlots[i] != iSlot)
+		return;
+
+	// Shift back any following entries that would no longer be reachable past the hole
+	int j = (i + 1) & (SIZE - 1);
+
+	for (int n = 1; n < SIZE && m_iKeys[j]; n++, j = (j + 1) & (SIZE - 1))
+	{
+		int iHome = Hash(m_iKeys[j]);
+
+		// Leave it if its home bucket lies cyclically in (i, j]
+		if (i <= j ? (i < iHome && iHome <= j) : (i < iHome || iHome <= j))
+			continue;
+
+		m_iKeys[i] = m_iKeys[j];
+		m_iSlots[i] = m_iSlots[j];
+		i = j;
+	}
+
+	m_iKeys[i] = 0;
+	m_iSlots[i] = -1;
+}
+
+int CSteamIdIndex::Find(uint64 iSteamId) const
+{
+	if (!iSteamId)
+		return -1;
+
+	int i = Hash(iSteamId);
+
+	for (int n = 0; n < SIZE && m_iKeys[i]; n++, i = (i + 1) & (SIZE - 1))
+		if (m_iKeys[i] == iSteamId)
+			return m_iSlots[i];
+
+	return -1;
+}
+
 extern CConVar<bool> g_cvarForceStopSound;
 
 void CPlayerManager::SetPlayerStopSound(int slot, bool set)
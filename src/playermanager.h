@@ -29,6 +29,7 @@
 #include "steam/steam_api_common.h"
 #include "steam/steamclientpublic.h"
 #include "utlvector.h"
+#include <bit>
 #include <playerslot.h>
 
 #define NO_TARGET_BLOCKS (0)
@@ -104,6 +105,9 @@ enum class ETargetError
 };
 
 class ZEPlayer;
+class CBasePlayerPawn;
+class CCSPlayerController;
+class CCSPlayerPawn;
 struct ZRClass;
 struct ZRModelEntry;
 
@@ -144,12 +148,56 @@ private:
 	};
 };
 
+// Player state touched every tick, kept out of ZEPlayer in one dense array per field so the
+// per-frame loops over every slot stream through a few cache lines instead of 64 heap objects.
+// ZEPlayer only holds the rarely touched state and reads these through its accessors
+struct PlayerHotData_t
+{
+	alignas(64) uint64 iTransmitBlockMask[MAXPLAYERS]; // Players hidden from this one
+	alignas(64) uint64 iLastInputs[MAXPLAYERS];
+	alignas(64) std::time_t iLastInputTime[MAXPLAYERS];
+	alignas(64) int iHideDistance[MAXPLAYERS]; // Copy of the hide distance preference
+	alignas(64) float flSpeedMod[MAXPLAYERS];
+	alignas(64) float flMaxSpeed[MAXPLAYERS];
+	alignas(64) uint32 iPlayerState[MAXPLAYERS];
+	alignas(64) CHandle<CBarnLight> hFlashLight[MAXPLAYERS];
+	alignas(64) CHandle<CBaseModelEntity> hGlowModel[MAXPLAYERS];
+	alignas(64) CHandle<CPointWorldText> hEntwatchHud[MAXPLAYERS];
+	alignas(64) CHandle<CParticleSystem> hBeaconParticle[MAXPLAYERS];
+	alignas(64) bool bHoldingRMB[MAXPLAYERS];
+	bool bIsLeader[MAXPLAYERS];
+
+	void Reset(int iSlot)
+	{
+		iTransmitBlockMask[iSlot] = 0;
+		iLastInputs[iSlot] = IN_NONE;
+		iLastInputTime[iSlot] = std::time(0);
+		iHideDistance[iSlot] = 0;
+		flSpeedMod[iSlot] = 1.f;
+		flMaxSpeed[iSlot] = 1.f;
+		iPlayerState[iSlot] = 1; // STATE_WELCOME is the initial state
+		hFlashLight[iSlot].Set(nullptr);
+		hGlowModel[iSlot].Set(nullptr);
+		hEntwatchHud[iSlot].Set(nullptr);
+		hBeaconParticle[iSlot].Set(nullptr);
+		bHoldingRMB[iSlot] = false;
+		bIsLeader[iSlot] = false;
+	}
+};
+
+extern PlayerHotData_t g_playerHotData;
+
+// Forgets every hide decision made for or about the player in iSlot, so a new player there doesn't inherit them
+void ResetHideDecisions(int iSlot);
+
 class ZEPlayer
 {
 public:
 	ZEPlayer(CPlayerSlot slot, bool m_bFakeClient = false) :
 		m_slot(slot), m_bFakeClient(m_bFakeClient), m_Handle(slot)
 	{
+		g_playerHotData.Reset(slot.Get());
+		ResetHideDecisions(slot.Get());
 		m_bAuthenticated = false;
 		m_iAdminFlags = 0;
 		m_iAdminImmunity = 0;
@@ -157,7 +205,6 @@ public:
 		m_bGagged = false;
 		m_bMuted = false;
 		m_bEbanned = false;
-		m_iHideDistance = 0;
 		m_bConnected = false;
 		m_iTotalDamage = 0;
 		m_iTotalHits = 0;
@@ -172,19 +219,12 @@ public:
 		m_bInGame = false;
 		m_iMZImmunity = 0; // out of 100
 		m_flNominateTime = -60.0f;
-		m_iPlayerState = 1; // STATE_WELCOME is the initial state
-		m_bIsLeader = false;
 		m_handleMark = nullptr;
 		m_colorLeader = Color(0, 0, 0, 0);
 		m_colorTracer = Color(0, 0, 0, 0);
 		m_colorGlow = Color(0, 0, 0, 0);
 		m_colorBeacon = Color(0, 0, 0, 0);
 		m_flLeaderVoteTime = -30.0f;
-		m_bHoldingRMB = false;
-		m_flSpeedMod = 1.f;
-		m_flMaxSpeed = 1.f;
-		m_iLastInputs = IN_NONE;
-		m_iLastInputTime = std::time(0);
 		m_pActiveZRClass = nullptr;
 		m_pActiveZRModel = nullptr;
 		m_iButtonWatchMode = 0;
@@ -198,7 +238,7 @@ public:
 
 	~ZEPlayer()
 	{
-		CBarnLight* pFlashLight = m_hFlashLight.Get();
+		CBarnLight* pFlashLight = GetFlashLight();
 
 		if (pFlashLight)
 			pFlashLight->Remove();
@@ -223,8 +263,12 @@ public:
 	void SetMuted(bool muted) { m_bMuted = muted; }
 	void SetGagged(bool gagged) { m_bGagged = gagged; }
 	void SetEbanned(bool ebanned) { m_bEbanned = ebanned; }
-	void SetTransmit(int index, bool shouldTransmit) { shouldTransmit ? m_shouldTransmit.Set(index) : m_shouldTransmit.Clear(index); }
-	void ClearTransmit() { m_shouldTransmit.ClearAll(); }
+	void SetTransmit(int index, bool shouldTransmit)
+	{
+		uint64& iMask = g_playerHotData.iTransmitBlockMask[m_slot.Get()];
+		iMask = shouldTransmit ? iMask | (1ull << index) : iMask & ~(1ull << index);
+	}
+	void ClearTransmit() { g_playerHotData.iTransmitBlockMask[m_slot.Get()] = 0; }
 	void SetHideDistance(int distance);
 	void SetTotalDamage(int damage) { m_iTotalDamage = damage; }
 	void SetTotalHits(int hits) { m_iTotalHits = hits; }
@@ -238,21 +282,21 @@ public:
 	void SetInGame(bool bInGame) { m_bInGame = bInGame; }
 	void SetImmunity(int iMZImmunity) { m_iMZImmunity = iMZImmunity; }
 	void SetNominateTime(float flCurtime) { m_flNominateTime = flCurtime; }
-	void SetFlashLight(CBarnLight* pLight) { m_hFlashLight.Set(pLight); }
-	void SetBeaconParticle(CParticleSystem* pParticle) { m_hBeaconParticle.Set(pParticle); }
-	void SetPlayerState(uint32 iPlayerState) { m_iPlayerState = iPlayerState; }
-	void SetLeader(bool bIsLeader) { m_bIsLeader = bIsLeader; }
+	void SetFlashLight(CBarnLight* pLight) { g_playerHotData.hFlashLight[m_slot.Get()].Set(pLight); }
+	void SetBeaconParticle(CParticleSystem* pParticle) { g_playerHotData.hBeaconParticle[m_slot.Get()].Set(pParticle); }
+	void SetPlayerState(uint32 iPlayerState) { g_playerHotData.iPlayerState[m_slot.Get()] = iPlayerState; }
+	void SetLeader(bool bIsLeader) { g_playerHotData.bIsLeader[m_slot.Get()] = bIsLeader; }
 	void CreateMark(float fDuration, Vector vecOrigin);
 	void SetLeaderColor(Color colorLeader) { m_colorLeader = colorLeader; }
 	void SetTracerColor(Color colorTracer) { m_colorTracer = colorTracer; }
 	void SetGlowColor(Color colorGlow) { m_colorGlow = colorGlow; }
 	void SetBeaconColor(Color colorBeacon) { m_colorBeacon = colorBeacon; }
 	void SetLeaderVoteTime(float flCurtime) { m_flLeaderVoteTime = flCurtime; }
-	void SetGlowModel(CBaseModelEntity* pModel) { m_hGlowModel.Set(pModel); }
-	void SetSpeedMod(float flSpeedMod) { m_flSpeedMod = flSpeedMod; }
-	void SetLastInputs(uint64 iLastInputs) { m_iLastInputs = iLastInputs; }
-	void UpdateLastInputTime() { m_iLastInputTime = std::time(0); }
-	void SetMaxSpeed(float flMaxSpeed) { m_flMaxSpeed = flMaxSpeed; } // BROKEN ON WINDOWS
+	void SetGlowModel(CBaseModelEntity* pModel) { g_playerHotData.hGlowModel[m_slot.Get()].Set(pModel); }
+	void SetSpeedMod(float flSpeedMod) { g_playerHotData.flSpeedMod[m_slot.Get()] = flSpeedMod; }
+	void SetLastInputs(uint64 iLastInputs) { g_playerHotData.iLastInputs[m_slot.Get()] = iLastInputs; }
+	void UpdateLastInputTime() { g_playerHotData.iLastInputTime[m_slot.Get()] = std::time(0); }
+	void SetMaxSpeed(float flMaxSpeed) { g_playerHotData.flMaxSpeed[m_slot.Get()] = flMaxSpeed; } // BROKEN ON WINDOWS
 	void CycleButtonWatch();
 	void ReplicateConVar(const char* pszName, const char* pszValue);
 	void SetActiveZRClass(std::shared_ptr<ZRClass> pZRModel) { m_pActiveZRClass = pZRModel; }
@@ -260,7 +304,7 @@ public:
 	void SetEntwatchHudMode(int iMode);
 	void SetEntwatchClangtags(bool bStatus);
 	void SetPointOrient(CPointOrient* pOrient) { m_hPointOrient.Set(pOrient); }
-	void SetEntwatchHud(CPointWorldText* pWorldText) { m_hEntwatchHud.Set(pWorldText); }
+	void SetEntwatchHud(CPointWorldText* pWorldText) { g_playerHotData.hEntwatchHud[m_slot.Get()].Set(pWorldText); }
 	void SetEntwatchHudColor(Color colorHud);
 	void SetEntwatchHudPos(float x, float y);
 	void SetEntwatchHudSize(float flSize);
@@ -270,7 +314,9 @@ public:
 	bool IsMuted() { return m_bMuted; }
 	bool IsGagged() { return m_bGagged; }
 	bool IsEbanned() { return m_bEbanned; }
-	bool ShouldBlockTransmit(int index) { return m_shouldTransmit.Get(index); }
+	bool ShouldBlockTransmit(int index) { return g_playerHotData.iTransmitBlockMask[m_slot.Get()] & (1ull << index); }
+	void SetTransmitMask(uint64 iMask) { g_playerHotData.iTransmitBlockMask[m_slot.Get()] = iMask; }
+	uint64 GetTransmitBlockMask() { return g_playerHotData.iTransmitBlockMask[m_slot.Get()]; }
 	int GetHideDistance();
 	CPlayerSlot GetPlayerSlot() { return m_slot; }
 	int GetTotalDamage() { return m_iTotalDamage; }
@@ -285,11 +331,11 @@ public:
 	bool IsInGame() { return m_bInGame; }
 	int GetImmunity() { return m_iMZImmunity; }
 	float GetNominateTime() { return m_flNominateTime; }
-	CBarnLight* GetFlashLight() { return m_hFlashLight.Get(); }
-	CParticleSystem* GetBeaconParticle() { return m_hBeaconParticle.Get(); }
+	CBarnLight* GetFlashLight() { return g_playerHotData.hFlashLight[m_slot.Get()].Get(); }
+	CParticleSystem* GetBeaconParticle() { return g_playerHotData.hBeaconParticle[m_slot.Get()].Get(); }
 	ZEPlayerHandle GetHandle() { return m_Handle; }
-	uint32 GetPlayerState() { return m_iPlayerState; }
-	bool IsLeader() { return m_bIsLeader; }
+	uint32 GetPlayerState() { return g_playerHotData.iPlayerState[m_slot.Get()]; }
+	bool IsLeader() { return g_playerHotData.bIsLeader[m_slot.Get()]; }
 	Color GetLeaderColor() { return m_colorLeader; }
 	Color GetTracerColor() { return m_colorTracer; }
 	Color GetGlowColor() { return m_colorGlow; }
@@ -297,18 +343,18 @@ public:
 	int GetLeaderVoteCount();
 	bool HasPlayerVotedLeader(ZEPlayer* pPlayer);
 	float GetLeaderVoteTime() { return m_flLeaderVoteTime; }
-	CBaseModelEntity* GetGlowModel() { return m_hGlowModel.Get(); }
-	float GetSpeedMod() { return m_flSpeedMod; }
-	float GetMaxSpeed() { return m_flMaxSpeed; }
-	uint64 GetLastInputs() { return m_iLastInputs; }
-	std::time_t GetLastInputTime() { return m_iLastInputTime; }
+	CBaseModelEntity* GetGlowModel() { return g_playerHotData.hGlowModel[m_slot.Get()].Get(); }
+	float GetSpeedMod() { return g_playerHotData.flSpeedMod[m_slot.Get()]; }
+	float GetMaxSpeed() { return g_playerHotData.flMaxSpeed[m_slot.Get()]; }
+	uint64 GetLastInputs() { return g_playerHotData.iLastInputs[m_slot.Get()]; }
+	std::time_t GetLastInputTime() { return g_playerHotData.iLastInputTime[m_slot.Get()]; }
 	std::shared_ptr<ZRClass> GetActiveZRClass() { return m_pActiveZRClass; }
 	std::shared_ptr<ZRModelEntry> GetActiveZRModel() { return m_pActiveZRModel; }
 	int GetButtonWatchMode();
 	int GetEntwatchHudMode();
 	bool GetEntwatchClangtags() { return m_bEntwatchClantags; }
 	CPointOrient* GetPointOrient() { return m_hPointOrient.Get(); }
-	CPointWorldText* GetEntwatchHud() { return m_hEntwatchHud.Get(); }
+	CPointWorldText* GetEntwatchHud() { return g_playerHotData.hEntwatchHud[m_slot.Get()].Get(); }
 	Color GetEntwatchHudColor() { return m_colorEntwatchHud; }
 	float GetEntwatchHudX() { return m_flEntwatchHudX; }
 	float GetEntwatchHudY() { return m_flEntwatchHudY; }
@@ -330,8 +376,10 @@ public:
 	void CreateEntwatchHud();
 	void CreatePointOrient();
 
+	bool IsHoldingRMB() { return g_playerHotData.bHoldingRMB[m_slot.Get()]; } // 按着鼠标右键
+	void SetHoldingRMB(bool bHoldingRMB) { g_playerHotData.bHoldingRMB[m_slot.Get()] = bHoldingRMB; }
+
 	int LastHideDistance = 0; // 上次 hide 的距离
-	bool HoldingRMB = false;  // 按着鼠标右键
 
 private:
 	bool m_bAuthenticated;
@@ -345,13 +393,10 @@ private:
 	bool m_bEbanned;
 	uint64 m_iAdminFlags;
 	int m_iAdminImmunity;
-	int m_iHideDistance;
-	CBitVec<MAXPLAYERS> m_shouldTransmit;
 	int m_iTotalDamage;
 	int m_iTotalHits;
 	int m_iTotalKills;
 	bool m_bVotedRTV;
-	bool m_bHoldingRMB;
 	float m_flRTVVoteTime;
 	bool m_bVotedExtend;
 	bool m_bIsInfected;
@@ -362,11 +407,7 @@ private:
 	bool m_bInGame;
 	int m_iMZImmunity;
 	float m_flNominateTime;
-	CHandle<CBarnLight> m_hFlashLight;
-	CHandle<CParticleSystem> m_hBeaconParticle;
-	uint32 m_iPlayerState;
 	ZEPlayerHandle m_Handle;
-	bool m_bIsLeader;
 	CHandle<CBaseEntity> m_handleMark;
 	Color m_colorLeader;
 	Color m_colorTracer;
@@ -374,16 +415,10 @@ private:
 	Color m_colorBeacon;
 	CUtlVector<ZEPlayerHandle> m_vecLeaderVotes;
 	float m_flLeaderVoteTime;
-	CHandle<CBaseModelEntity> m_hGlowModel;
-	float m_flSpeedMod;
-	float m_flMaxSpeed;
-	uint64 m_iLastInputs;
-	std::time_t m_iLastInputTime;
 	std::shared_ptr<ZRClass> m_pActiveZRClass;
 	std::shared_ptr<ZRModelEntry> m_pActiveZRModel;
 	int m_iButtonWatchMode;
 	CHandle<CPointOrient> m_hPointOrient;
-	CHandle<CPointWorldText> m_hEntwatchHud;
 	int m_iEntwatchHudMode;
 	bool m_bEntwatchClantags;
 	Color m_colorEntwatchHud;
@@ -392,6 +427,84 @@ private:
 	float m_flEntwatchHudSize;
 };
 
+// A slot's entities and the state the per-frame player loops need, captured once at the start of every frame.
+// Pointers to entities deleted during the frame are cleared
+struct PlayerSnapshot_t
+{
+	CCSPlayerController* pController;
+	CBasePlayerPawn* pPawn;		// Current pawn, which is the observer pawn while spectating
+	CCSPlayerPawn* pPlayerPawn; // The actual player pawn
+	Vector vecOrigin;			// Of pPawn
+	int iTeam;
+	bool bAlive;		// pPawn is alive
+	bool bPawnIsAlive;	// m_bPawnIsAlive of the controller
+	bool bHasButtons;	// pPawn has movement services
+	uint64 iButtons[2]; // Held and changed buttons of pPawn
+};
+
+// Walks the slots set in a player mask, lowest first: for (int i : PlayerBits(iMask))
+class CPlayerBitIterator
+{
+public:
+	CPlayerBitIterator(uint64 iBits) :
+		m_iBits(iBits) {}
+
+	int operator*() const { return std::countr_zero(m_iBits); }
+	CPlayerBitIterator& operator++()
+	{
+		m_iBits &= m_iBits - 1;
+		return *this;
+	}
+	bool operator!=(const CPlayerBitIterator& other) const { return m_iBits != other.m_iBits; }
+
+private:
+	uint64 m_iBits;
+};
+
+struct PlayerBits
+{
+	PlayerBits(uint64 iBits) :
+		iBits(iBits) {}
+
+	CPlayerBitIterator begin() const { return iBits; }
+	CPlayerBitIterator end() const { return 0ull; }
+
+	uint64 iBits;
+};
+
+// Open addressing map from authenticated SteamID to player slot, linear probing with
+// backward shift deletion so there are never any tombstones
+class CSteamIdIndex
+{
+public:
+	CSteamIdIndex() { Clear(); }
+
+	void Clear();
+	void Insert(uint64 iSteamId, int iSlot);
+
+	// Only removes the entry if it still points to iSlot, the same account can briefly be in two slots while reconnecting
+	void Remove(uint64 iSteamId, int iSlot);
+
+	// -1 if not found
+	int Find(uint64 iSteamId) const;
+
+private:
+	// Twice the player count keeps the probe sequences short
+	static constexpr int SIZE = MAXPLAYERS * 2;
+
+	static int Hash(uint64 iSteamId)
+	{
+		// The low 32 bits are the account id, mixing the whole thing still costs next to nothing
+		iSteamId ^= iSteamId >> 33;
+		iSteamId *= 0xff51afd7ed558ccdull;
+		iSteamId ^= iSteamId >> 33;
+		return iSteamId & (SIZE - 1);
+	}
+
+	uint64 m_iKeys[SIZE]; // 0 marks an empty bucket, never a valid SteamID
+	int8 m_iSlots[SIZE];
+};
+
 class CPlayerManager
 {
 public:
@@ -410,7 +523,10 @@ public:
 	void OnClientPutInServer(CPlayerSlot slot);
 	void OnLateLoad();
 	void OnSteamAPIActivated();
+	void OnPlayerAuthenticated(ZEPlayer* pPlayer);
 	void CheckInfractions();
+	void UpdateSnapshot();
+	void OnEntityDeleted(CEntityInstance* pEntity);
 	void FlashLightThink();
 	void CheckHideDistances();
 	void SetupInfiniteAmmo();
@@ -425,6 +541,20 @@ public:
 
 	ZEPlayer* GetPlayer(CPlayerSlot slot);
 
+	// nullptr if the slot had no controller at the start of the frame
+	const PlayerSnapshot_t* GetSnapshot(CPlayerSlot slot)
+	{
+		if (slot.Get() < 0 || slot.Get() >= MAXPLAYERS || !m_snapshot[slot.Get()].pController)
+			return nullptr;
+
+		return &m_snapshot[slot.Get()];
+	}
+
+	// Slots with a ZEPlayer, bots included
+	uint64 GetConnectedMask() { return m_iConnectedMask; }
+	uint64 GetInGameMask() { return m_iInGameMask; }
+	uint64 GetFakeClientMask() { return m_iFakeClientMask; }
+
 	uint64 GetStopSoundMask() { return m_nUsingStopSound; }
 	uint64 GetSilenceSoundMask() { return m_nUsingSilenceSound; }
 	uint64 GetStopDecalsMask() { return m_nUsingStopDecals; }
@@ -448,7 +578,17 @@ public:
 	STEAM_GAMESERVER_CALLBACK_MANUAL(CPlayerManager, OnValidateAuthTicket, ValidateAuthTicketResponse_t, m_CallbackValidateAuthTicketResponse);
 
 private:
+	uint64 GetTargetCandidates(uint64 iBlockedFlags);
+	int GetRandomTarget(CCSPlayerController* pPlayer, uint64 iBlockedFlags);
+
 	ZEPlayer* m_vecPlayers[MAXPLAYERS];
+	PlayerSnapshot_t m_snapshot[MAXPLAYERS];
+
+	CSteamIdIndex m_steamIdIndex;
+
+	uint64 m_iConnectedMask = 0;
+	uint64 m_iInGameMask = 0;
+	uint64 m_iFakeClientMask = 0;
 
 	uint64 m_nUsingStopSound;
 	uint64 m_nUsingSilenceSound;
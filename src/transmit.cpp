@@ -0,0 +1,204 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transmit.h"
+#include "commands.h"
+#include "entity/ccsplayercontroller.h"
+#include "entity/ccsplayerpawn.h"
+#include "entwatch.h"
+#include "eventlistener.h"
+#include "playermanager.h"
+#include <vprof.h>
+
+extern CGlobalVars* GetGlobals();
+extern CConVar<bool> g_cvarFlashLightTransmitOthers;
+extern CConVar<bool> g_cvarEnableHideDeadPlayer;
+
+static_assert(TRANSMIT_MAX_PLAYERS == MAXPLAYERS, "transmit_rules.h has to cover every player slot");
+
+// 和 c# 搭配的 transmit 互通接口, stored as a sparse list so each viewer only pays for the entries that are set
+struct TransmitOverrides_t
+{
+	uint64 iForceTransmitMask;
+	int nClear;
+	int clear[TRANSMIT_MAX_CLEAR];
+};
+
+static TransmitOverrides_t g_transmitOverrides[MAXPLAYERS];
+
+void Transmit_SetOverrides(int iSlot, const int* pClearEntities, int nClearEntities, uint64 iForceTransmitMask)
+{
+	if (iSlot < 0 || iSlot >= MAXPLAYERS)
+		return;
+
+	TransmitOverrides_t& overrides = g_transmitOverrides[iSlot];
+	overrides.iForceTransmitMask = iForceTransmitMask;
+	overrides.nClear = 0;
+
+	for (int i = 0; i < nClearEntities && overrides.nClear < TRANSMIT_MAX_CLEAR; i++)
+	{
+		if (pClearEntities[i] > 0 && pClearEntities[i] < TRANSMIT_MAX_EDICTS)
+			overrides.clear[overrides.nClear++] = pClearEntities[i];
+	}
+}
+
+// Events with a "clear_count" key only carry clear0..clear<count - 1> and the force transmit players as a 64-bit "add_mask",
+// otherwise every clear%d and add%d key is read like before
+GAME_EVENT_F2(choppers_incoming_warning, pre_transmit_entity_clear)
+{
+	auto customEventName = pEvent->GetString("custom_event", "");
+	if (strcmp(customEventName, "pre_transmit_entity_clear") != 0)
+		return;
+	int slot = pEvent->GetInt("player_index", -1);
+	if (slot < 1 || slot > 64) return;
+	slot = slot - 1;
+
+	int clear[TRANSMIT_MAX_CLEAR];
+	int nClear = 0;
+	uint64 iForceTransmitMask = 0;
+	int iClearCount = pEvent->GetInt("clear_count", -1);
+
+	if (iClearCount >= 0)
+	{
+		nClear = MIN(iClearCount, TRANSMIT_MAX_CLEAR);
+		iForceTransmitMask = pEvent->GetUint64("add_mask");
+	}
+	else
+	{
+		nClear = TRANSMIT_MAX_CLEAR;
+	}
+
+	for (int i = 0; i < nClear; i++)
+	{
+		char name[32];
+		V_snprintf(name, sizeof(name), "clear%d", i);
+		clear[i] = pEvent->GetInt(name);
+	}
+
+	if (iClearCount < 0)
+	{
+		for (int i = 0; i < 64; i++)
+		{
+			char name[32];
+			V_snprintf(name, sizeof(name), "add%d", i);
+			if (pEvent->GetBool(name, false))
+				iForceTransmitMask |= 1ull << i;
+		}
+	}
+
+	Transmit_SetOverrides(slot, clear, nClear, iForceTransmitMask);
+}
+
+static TransmitScene_t g_transmitScene;
+static TransmitShared_t g_transmitShared;
+static CTransmitMask g_transmitMasks[MAXPLAYERS];
+static int g_iTransmitTick = -1;
+
+void Transmit_GatherScene(TransmitScene_t& scene)
+{
+	scene.iMaxClients = MIN(GetGlobals()->maxClients, MAXPLAYERS);
+	scene.bHide = g_cvarEnableHide.Get();
+	scene.bHideDead = g_cvarEnableHideDeadPlayer.Get();
+	scene.bFlashLightTransmitOthers = g_cvarFlashLightTransmitOthers.Get();
+
+	bool bEntwatchHud = g_cvarEnableEntWatch.Get() && g_pEWHandler->IsConfigLoaded();
+
+	for (int i = 0; i < scene.iMaxClients; i++)
+	{
+		TransmitPlayer_t& player = scene.players[i];
+		player = {};
+		player.iPawn = player.iFlashLight = player.iEntwatchHud = player.iGlowModel = -1;
+		player.pClearList = g_transmitOverrides[i].clear;
+		player.nClearList = g_transmitOverrides[i].nClear;
+
+		CCSPlayerController* pController = CCSPlayerController::FromSlot(i);
+
+		if (!pController)
+			continue;
+
+		player.bValid = !pController->m_bIsHLTV;
+
+		// Get the actual pawn as the player could be currently spectating
+		CCSPlayerPawn* pPawn = pController->GetPlayerPawn();
+
+		if (pPawn)
+		{
+			player.iPawn = pPawn->entindex();
+			player.bAlive = pPawn->IsAlive();
+		}
+
+		ZEPlayer* pZEPlayer = g_playerManager->GetPlayer(i);
+
+		if (!pZEPlayer)
+			continue;
+
+		player.bLeader = pZEPlayer->IsLeader();
+		player.bBeacon = pZEPlayer->GetBeaconParticle() != nullptr;
+
+		if (!pController->IsConnected())
+			continue;
+
+		player.bViewer = true;
+		player.bObserver = pController->GetPawnState() == STATE_OBSERVER_MODE;
+		player.bHoldingRMB = pZEPlayer->IsHoldingRMB();
+		player.iBlockMask = pZEPlayer->GetTransmitBlockMask();
+		player.iForceTransmitMask = g_transmitOverrides[i].iForceTransmitMask;
+
+		if (CBarnLight* pFlashLight = pZEPlayer->GetFlashLight())
+			player.iFlashLight = pFlashLight->entindex();
+
+		if (CPointWorldText* pHud = bEntwatchHud ? pZEPlayer->GetEntwatchHud() : nullptr)
+			player.iEntwatchHud = pHud->entindex();
+
+		if (CBaseModelEntity* pGlowModel = pZEPlayer->GetGlowModel())
+			player.iGlowModel = pGlowModel->entindex();
+	}
+}
+
+void Transmit_Update()
+{
+	if (GetGlobals()->tickcount == g_iTransmitTick)
+		return;
+
+	VPROF("Transmit_Update");
+
+	g_iTransmitTick = GetGlobals()->tickcount;
+
+	Transmit_GatherScene(g_transmitScene);
+	Transmit_BuildShared(g_transmitScene, g_transmitShared);
+
+	for (int i = 0; i < g_transmitScene.iMaxClients; i++)
+		Transmit_BuildMask(g_transmitScene, g_transmitShared, i, g_transmitMasks[i]);
+}
+
+void Transmit_Apply(int iSlot, CBitVec<TRANSMIT_MAX_EDICTS>& transmit)
+{
+	if (iSlot < 0 || iSlot >= g_transmitScene.iMaxClients)
+		return;
+
+	g_transmitMasks[iSlot].RemoveFrom(transmit.Base());
+}
+
+void Transmit_Invalidate()
+{
+	g_iTransmitTick = -1;
+
+	for (int i = 0; i < MAXPLAYERS; i++)
+		g_transmitMasks[i].Reset();
+}
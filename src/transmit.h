@@ -0,0 +1,33 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "bitvec.h"
+#include "common.h"
+#include "transmit_rules.h"
+
+// Replaces what the C# side wants hidden from or always transmitted to a player, see ICS2Fixes::SetTransmitOverrides
+void Transmit_SetOverrides(int iSlot, const int* pClearEntities, int nClearEntities, uint64 iForceTransmitMask);
+
+void Transmit_GatherScene(TransmitScene_t& scene);
+
+// Rebuilds every viewer's mask, only does work on the first call of a tick
+void Transmit_Update();
+void Transmit_Apply(int iSlot, CBitVec<TRANSMIT_MAX_EDICTS>& transmit);
+void Transmit_Invalidate();
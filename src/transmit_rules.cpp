@@ -0,0 +1,213 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transmit_rules.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+static void ClearTransmitBit(uint32_t* pTransmit, int iEntity)
+{
+	pTransmit[iEntity >> 5] &= ~(1u << (iEntity & 31));
+}
+
+void CTransmitMask::Reset()
+{
+	for (int i = m_iFirstWord; i <= m_iLastWord; i++)
+		m_words[i] = 0;
+
+	m_iFirstWord = TRANSMIT_MAX_EDICTS / 32;
+	m_iLastWord = -1;
+}
+
+void CTransmitMask::Set(int iEntity)
+{
+	if (iEntity < 0 || iEntity >= TRANSMIT_MAX_EDICTS)
+		return;
+
+	int iWord = iEntity >> 5;
+	m_words[iWord] |= 1u << (iEntity & 31);
+	m_iFirstWord = std::min(m_iFirstWord, iWord);
+	m_iLastWord = std::max(m_iLastWord, iWord);
+}
+
+void CTransmitMask::Clear(int iEntity)
+{
+	if (iEntity < 0 || iEntity >= TRANSMIT_MAX_EDICTS)
+		return;
+
+	m_words[iEntity >> 5] &= ~(1u << (iEntity & 31));
+}
+
+void CTransmitMask::CopyFrom(const CTransmitMask& other)
+{
+	Reset();
+
+	if (other.IsEmpty())
+		return;
+
+	memcpy(m_words + other.m_iFirstWord, other.m_words + other.m_iFirstWord, (other.m_iLastWord - other.m_iFirstWord + 1) * sizeof(uint32_t));
+	m_iFirstWord = other.m_iFirstWord;
+	m_iLastWord = other.m_iLastWord;
+}
+
+void CTransmitMask::RemoveFrom(uint32_t* pTransmit) const
+{
+	for (int i = m_iFirstWord; i <= m_iLastWord; i++)
+		pTransmit[i] &= ~m_words[i];
+}
+
+void Transmit_BuildShared(const TransmitScene_t& scene, TransmitShared_t& shared)
+{
+	shared.mask.Reset();
+	shared.iDeadPawns = 0;
+	shared.iAlivePawns = 0;
+	shared.iNeverHidden = 0;
+
+	for (int i = 0; i < scene.iMaxClients; i++)
+	{
+		const TransmitPlayer_t& player = scene.players[i];
+
+		if (!player.bValid)
+			continue;
+
+		// Don't transmit players' flashlights and entwatch hud to anyone else
+		if (!scene.bFlashLightTransmitOthers)
+			shared.mask.Set(player.iFlashLight);
+
+		shared.mask.Set(player.iEntwatchHud);
+
+		if (player.iPawn != -1)
+		{
+			if (player.bAlive)
+				shared.iAlivePawns |= 1ull << i;
+			else
+				shared.iDeadPawns |= 1ull << i;
+		}
+
+		if (player.bLeader || player.bBeacon)
+			shared.iNeverHidden |= 1ull << i;
+	}
+}
+
+void Transmit_BuildMask(const TransmitScene_t& scene, const TransmitShared_t& shared, int iViewer, CTransmitMask& mask)
+{
+	const TransmitPlayer_t& viewer = scene.players[iViewer];
+
+	if (!viewer.bViewer)
+	{
+		mask.Reset();
+		return;
+	}
+
+	mask.CopyFrom(shared.mask);
+
+	// Always transmit to themselves
+	if (viewer.bValid)
+	{
+		mask.Clear(viewer.iFlashLight);
+		mask.Clear(viewer.iEntwatchHud);
+	}
+
+	for (int i = 0; i < viewer.nClearList; i++)
+		if (viewer.pClearList[i] > 0)
+			mask.Set(viewer.pClearList[i]);
+
+	// Always transmit other players if spectating, or while holding RMB (如果按着鼠标右键就不 hide 队友)
+	if (scene.bHide && !viewer.bObserver && !viewer.bHoldingRMB)
+	{
+		// Hide players marked as hidden or ANY dead player, it seems that a ragdoll of a previously hidden player can crash?
+		// TODO: Revert this if/when valve fixes the issue?
+		// Players the C# side asked for are transmitted, and leaders or players with a beacon are never hidden
+		uint64_t iHidden = shared.iAlivePawns & viewer.iBlockMask & ~viewer.iForceTransmitMask & ~shared.iNeverHidden;
+
+		if (scene.bHideDead)
+			iHidden |= shared.iDeadPawns;
+
+		iHidden &= ~(1ull << iViewer);
+
+		for (; iHidden; iHidden &= iHidden - 1)
+			mask.Set(scene.players[std::countr_zero(iHidden)].iPawn);
+	}
+
+	// Don't transmit glow model to it's owner
+	mask.Set(viewer.iGlowModel);
+}
+
+void Transmit_ApplyReference(const TransmitScene_t& scene, int iViewer, uint32_t* pTransmit)
+{
+	const TransmitPlayer_t& viewer = scene.players[iViewer];
+
+	if (!viewer.bViewer)
+		return;
+
+	for (int j = 0; j < viewer.nClearList; j++)
+	{
+		int entIndex = viewer.pClearList[j];
+		if (entIndex > 0 && entIndex < TRANSMIT_MAX_EDICTS)
+			ClearTransmitBit(pTransmit, entIndex);
+	}
+
+	for (int j = 0; j < scene.iMaxClients; j++)
+	{
+		const TransmitPlayer_t& other = scene.players[j];
+
+		if (!other.bValid || j == iViewer)
+			continue;
+
+		if (!scene.bFlashLightTransmitOthers && other.iFlashLight != -1)
+			ClearTransmitBit(pTransmit, other.iFlashLight);
+
+		if (other.iEntwatchHud != -1)
+			ClearTransmitBit(pTransmit, other.iEntwatchHud);
+
+		if (!scene.bHide || viewer.bObserver)
+			continue;
+
+		if (other.iPawn == -1)
+			continue;
+
+		if (viewer.bHoldingRMB)
+			continue;
+
+		bool shouldHide = false;
+		if (!other.bAlive)
+		{
+			if (scene.bHideDead)
+				shouldHide = true; // 死亡的玩家一定不传输
+		}
+		else if (viewer.iForceTransmitMask & (1ull << j))
+		{
+			shouldHide = false; // 白名单里要求的进行传输
+		}
+		else if (viewer.iBlockMask & (1ull << j))
+		{
+			shouldHide = true; // 没有要求的玩家按距离控制管理
+			if (other.bLeader)
+				shouldHide = false; // 指挥官不隐藏
+			else if (other.bBeacon)
+				shouldHide = false; // 有beacon的不隐藏
+		}
+		if (shouldHide)
+			ClearTransmitBit(pTransmit, other.iPawn);
+	}
+
+	if (viewer.iGlowModel != -1)
+		ClearTransmitBit(pTransmit, viewer.iGlowModel);
+}
@@ -0,0 +1,100 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// The transmit rules on their own, without any engine types, so tests/ can build and check them outside the game
+
+#define TRANSMIT_MAX_PLAYERS 64
+#define TRANSMIT_MAX_EDICTS 16384
+#define TRANSMIT_MAX_CLEAR 1024
+
+// Everything the transmit rules need to know about a player, gathered once per tick
+// so building the per-viewer masks never has to touch an entity
+struct TransmitPlayer_t
+{
+	bool bValid;  // Has a controller that isn't HLTV
+	bool bViewer; // Connected with a ZEPlayer, transmit rules are only applied to these
+	bool bObserver;
+	bool bHoldingRMB;
+	bool bAlive;
+	bool bLeader;
+	bool bBeacon;
+
+	// Entity indices, -1 when the entity doesn't exist
+	int iPawn;
+	int iFlashLight;
+	int iEntwatchHud;
+	int iGlowModel;
+
+	uint64_t iBlockMask;		 // Players hidden from this one by hide distance
+	uint64_t iForceTransmitMask; // Players the C# side always wants transmitted to this one
+
+	// Extra entities the C# side wants hidden from this one, entries <= 0 are skipped
+	const int* pClearList;
+	int nClearList;
+};
+
+struct TransmitScene_t
+{
+	int iMaxClients;
+	bool bHide;
+	bool bHideDead;
+	bool bFlashLightTransmitOthers;
+	TransmitPlayer_t players[TRANSMIT_MAX_PLAYERS];
+};
+
+// Entities to remove from one viewer's transmit list, tracks the range of words in use
+// so resetting and applying it doesn't have to walk the whole 16384 bits.
+// Words use the same bit order as CBitVec, so RemoveFrom can take a transmit list's Base()
+class CTransmitMask
+{
+public:
+	void Reset();
+	void Set(int iEntity);
+	void Clear(int iEntity);
+	void CopyFrom(const CTransmitMask& other);
+	bool IsSet(int iEntity) const { return m_words[iEntity >> 5] & (1u << (iEntity & 31)); }
+	bool IsEmpty() const { return m_iLastWord < m_iFirstWord; }
+
+	// transmit &= ~mask, pTransmit holds TRANSMIT_MAX_EDICTS bits
+	void RemoveFrom(uint32_t* pTransmit) const;
+
+private:
+	uint32_t m_words[TRANSMIT_MAX_EDICTS / 32] = {};
+	int m_iFirstWord = TRANSMIT_MAX_EDICTS / 32;
+	int m_iLastWord = -1;
+};
+
+// The parts of the masks that are the same for every viewer, built once per scene
+struct TransmitShared_t
+{
+	CTransmitMask mask; // Every player's flashlight and entwatch hud
+	uint64_t iAlivePawns;
+	uint64_t iDeadPawns;
+	uint64_t iNeverHidden; // Leaders and players with a beacon
+};
+
+void Transmit_BuildShared(const TransmitScene_t& scene, TransmitShared_t& shared);
+void Transmit_BuildMask(const TransmitScene_t& scene, const TransmitShared_t& shared, int iViewer, CTransmitMask& mask);
+
+// The original per-entity rules, kept to verify the masks against
+void Transmit_ApplyReference(const TransmitScene_t& scene, int iViewer, uint32_t* pTransmit);
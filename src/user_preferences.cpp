@@ -88,6 +88,17 @@ void CUserPreferencesSystem::ClearPreferences(int iSlot)
 	m_mPreferencesMaps[iSlot].clear();
 }
 
+// The player may have changed slots or left by the time the storage responds, so find them again by SteamID
+static void OnPreferencesResponse(uint64 iSteamId, UserPrefsMap_t& preferenceData)
+{
+	ZEPlayer* player = g_playerManager->GetPlayerFromSteamId(iSteamId);
+	if (!player) return;
+
+	int iSlot = player->GetPlayerSlot().Get();
+	if (g_pUserPreferencesSystem->PutPreferences(iSlot, iSteamId, preferenceData))
+		g_pUserPreferencesSystem->OnPutPreferences(iSlot);
+}
+
 bool CUserPreferencesSystem::PutPreferences(int iSlot, uint64 iSteamId, UserPrefsMap_t& preferenceData)
 {
 	ZEPlayer* player = g_playerManager->GetPlayer(CPlayerSlot(iSlot));
@@ -154,12 +165,7 @@ void CUserPreferencesSystem::PullPreferences(int iSlot)
 	if (!player || !player->IsAuthenticated()) return;
 	uint64 iSteamId = player->GetSteamId64();
 
-	g_pUserPreferencesStorage->LoadPreferences(
-		iSteamId,
-		[iSlot](uint64 iSteamId, UserPrefsMap_t& preferenceData) {
-			if (g_pUserPreferencesSystem->PutPreferences(iSlot, iSteamId, preferenceData))
-				g_pUserPreferencesSystem->OnPutPreferences(iSlot);
-		});
+	g_pUserPreferencesStorage->LoadPreferences(iSteamId, OnPreferencesResponse);
 }
 
 const char* CUserPreferencesSystem::GetPreference(int iSlot, const char* sKey, const char* sDefaultValue)
@@ -211,6 +217,10 @@ void CUserPreferencesSystem::SetPreference(int iSlot, const char* sKey, const ch
 	// Override the key-value pair and insert
 	m_mPreferencesMaps[iSlot][iKeyHash] = prefValue;
 
+	// Hide distance is read every tick, so the player keeps a copy of it
+	if (iKeyHash == hash_32_fnv1a_const(HIDE_DISTANCE_PREF_KEY_NAME))
+		g_playerHotData.iHideDistance[iSlot] = V_StringToInt32(sValue, 0);
+
 	IGameEvent* pEvent = g_gameEventManager->CreateEvent("choppers_incoming_warning");
 	if (pEvent) {
 		pEvent->SetString("custom_event", "cs2f_user_prefs_set");
@@ -276,10 +286,7 @@ void CUserPreferencesSystem::PushPreferences(int iSlot)
 	g_pUserPreferencesStorage->StorePreferences(
 		iSteamId,
 		m_mPreferencesMaps[iSlot],
-		[iSlot](uint64 iSteamId, UserPrefsMap_t& preferenceData) {
-			if (g_pUserPreferencesSystem->PutPreferences(iSlot, iSteamId, preferenceData))
-				g_pUserPreferencesSystem->OnPutPreferences(iSlot);
-		});
+		OnPreferencesResponse);
 }
 
 void CUserPreferencesREST::JsonToPreferencesMap(json data, UserPrefsMap_t& preferencesMap)
@@ -139,8 +139,13 @@ void SendHudMessageAll(int iDuration, EHudPriority ePriority, const char* pszMes
 
 void StartFlashingFixTimer()
 {
+	static CTimerHandle hFlashingFixTimer;
+
+	// This runs on every level init, make sure only one of these is ever ticking
+	CancelTimer(hFlashingFixTimer);
+
 	// Timer that fakes m_bGameRestart enabled, to fix flashing with show_survival_respawn_status
-	new CTimer(0.5f, false, true, []() {
+	hFlashingFixTimer = CreateTimer(0.5f, false, true, []() {
 		if (!g_cvarFixHudFlashing.Get() || !g_pGameRules)
 			return 0.5f;
 
@@ -22,22 +22,17 @@
 #include "dbg.h"
 #include "interface.h"
 #include "plat.h"
+#include "signature_scanner.h"
 #include "strtools.h"
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #ifdef _WIN32
 	#include <Psapi.h>
 #endif
 
-enum SigError
-{
-	SIG_OK,
-	SIG_NOT_FOUND,
-	SIG_FOUND_MULTIPLE,
-};
-
 // equivalent to FindSignature, but allows for multiple signatures to be found and iterated over
 class SignatureIterator
 {
@@ -108,48 +103,14 @@ public:
 		Message("Initialized module %s base: 0x%p | size: %d\n", m_pszModule, m_base, m_size);
 	}
 
+	// Use CSignatureScanner directly to find several signatures in one pass
 	void* FindSignature(const byte* pData, size_t iSigLength, int& error)
 	{
-		unsigned char* pMemory;
-		void* return_addr = nullptr;
-		error = 0;
-
-		pMemory = (byte*)m_base;
-
-		for (size_t i = 0; i < m_size; i++)
-		{
-			size_t Matches = 0;
-			while (i + Matches < m_size && (*(pMemory + i + Matches) == pData[Matches] || pData[Matches] == '\x2A'))
-			{
-				Matches++;
-				if (Matches == iSigLength)
-				{
-					if (return_addr)
-					{
-						error = SIG_FOUND_MULTIPLE;
-						return return_addr;
-					}
-
-					return_addr = (void*)(pMemory + i);
-					break;
-				}
-			}
-		}
-
-		if (!return_addr)
-			error = SIG_NOT_FOUND;
-		else
-		{
-			unsigned char insnByte = *(unsigned char*)return_addr;
-			if (insnByte == 0xE8 || insnByte == 0xE9)
-			{
-				uintptr_t addr = (uintptr_t) return_addr;
-				int jumpOffset = *(int*)(addr + 1);
-				return_addr = (void*)(addr + 5 + jumpOffset);
-			}
-		}
+		CSignatureScanner scanner;
+		scanner.AddSignature(pData, iSigLength);
+		scanner.Scan(m_base, m_size);
 
-		return return_addr;
+		return scanner.GetResult(0, error);
 	}
 
 	void* FindInterface(const char* name)
@@ -180,7 +141,30 @@ public:
 #ifdef _WIN32
 	void InitializeSections();
 #endif
-	void* FindVirtualTable(const std::string& name);
+
+	// Every class with RTTI is indexed on the first call, so later lookups don't scan the module again
+	void* FindVirtualTable(const std::string& name)
+	{
+		if (!m_bVirtualTablesIndexed)
+			IndexVirtualTables();
+
+		auto it = m_umVirtualTables.find(name);
+
+		if (it == m_umVirtualTables.end())
+		{
+			Warning("Failed to find vtable for %s\n", name.c_str());
+			return nullptr;
+		}
+
+		return it->second;
+	}
+
+	// Builds what FindVirtualTable looks up, only reads the module so it can run on another thread as long as nothing looks up
+	// a vtable of this module until it's done
+	void IndexVirtualTables();
+
+	// Hex string that changes whenever the binary does, empty if it can't be read
+	std::string GetBuildId();
 
 public:
 	const char* m_pszModule;
@@ -189,4 +173,8 @@ public:
 	void* m_base;
 	size_t m_size;
 	std::vector<Section> m_sections;
+
+private:
+	bool m_bVirtualTablesIndexed = false;
+	std::unordered_map<std::string, void*> m_umVirtualTables;
 };
\ No newline at end of file
@@ -60,4 +60,17 @@ int GetModuleInformation(HINSTANCE module, void** base, size_t* length, std::vec
 	#define MODULE_EXT ".so"
 #endif
 
-void Plat_WriteMemory(void* pPatchAddress, uint8_t* pPatch, int iPatchSize);
\ No newline at end of file
+void Plat_WriteMemory(void* pPatchAddress, uint8_t* pPatch, int iPatchSize);
+
+// While one of these is alive, Plat_WriteMemory copies the patch and queues it, and the outermost one writes everything
+// queued when it goes out of scope, so each page touched is only made writable and restored once
+class CMemoryWriteBatch
+{
+public:
+	CMemoryWriteBatch();
+	~CMemoryWriteBatch();
+
+private:
+	CMemoryWriteBatch(const CMemoryWriteBatch&) = delete;
+	CMemoryWriteBatch& operator=(const CMemoryWriteBatch&) = delete;
+};
\ No newline at end of file
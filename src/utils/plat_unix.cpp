@@ -25,6 +25,7 @@
 	#include "module.h"
 	#include "plat.h"
 	#include "sys/mman.h"
+	#include <algorithm>
 	#include <dlfcn.h>
 	#include <elf.h>
 	#include <fcntl.h>
@@ -140,17 +141,31 @@ static int parse_prot(const char* s)
 	return prot;
 }
 
-static int get_prot(void* pAddr, size_t nSize)
+struct MemoryRegion_t
 {
+	uintptr_t nStart;
+	uintptr_t nEnd;
+	int prot;
+};
+
+// Parsed /proc/self/maps sorted by address. Kept between writes and reparsed when a batch is written or a page isn't in it,
+// so an unbatched write only reads the map the first time or after something new was mapped
+static std::vector<MemoryRegion_t> g_vecMemoryRegions;
+
+static void parse_regions()
+{
+	g_vecMemoryRegions.clear();
+
 	FILE* f = fopen("/proc/self/maps", "r");
 
-	uintptr_t nAddr = (uintptr_t)pAddr;
+	if (!f)
+		return;
 
 	char line[512];
 	while (fgets(line, sizeof(line), f))
 	{
-		char start[16];
-		char end[16];
+		char start[32];
+		char end[32];
 		char prot[16];
 
 		const char* src = line;
@@ -174,69 +189,338 @@ static int get_prot(void* pAddr, size_t nSize)
 			*dst++ = *src++;
 		*dst = 0;
 
-		uintptr_t nStart = (uintptr_t)strtoul(start, nullptr, 16);
-		uintptr_t nEnd = (uintptr_t)strtoul(end, nullptr, 16);
+		MemoryRegion_t region;
+		region.nStart = (uintptr_t)strtoul(start, nullptr, 16);
+		region.nEnd = (uintptr_t)strtoul(end, nullptr, 16);
+		region.prot = parse_prot(prot);
 
-		if (nStart < nAddr && nEnd > (nAddr + nSize))
-		{
-			fclose(f);
-			return parse_prot(prot);
-		}
+		g_vecMemoryRegions.push_back(region);
 	}
 
 	fclose(f);
-	return 0;
+
+	// The kernel lists mappings in order already
+	std::sort(g_vecMemoryRegions.begin(), g_vecMemoryRegions.end(), [](const MemoryRegion_t& a, const MemoryRegion_t& b) { return a.nStart < b.nStart; });
 }
 
-void Plat_WriteMemory(void* pPatchAddress, uint8_t* pPatch, int iPatchSize)
+static const MemoryRegion_t* find_region(uintptr_t nAddr)
 {
-	int old_prot = get_prot(pPatchAddress, iPatchSize);
+	auto it = std::upper_bound(g_vecMemoryRegions.begin(), g_vecMemoryRegions.end(), nAddr, [](uintptr_t nAddr, const MemoryRegion_t& region) { return nAddr < region.nStart; });
 
-	uintptr_t page_size = sysconf(_SC_PAGESIZE);
-	uint8_t* align_addr = (uint8_t*)((uintptr_t)pPatchAddress & ~(page_size - 1));
+	if (it == g_vecMemoryRegions.begin() || nAddr >= (--it)->nEnd)
+		return nullptr;
+
+	return &(*it);
+}
+
+// Protection of the page at nAddr as of the last parse, -1 if it isn't mapped
+static int get_prot(uintptr_t nAddr)
+{
+	const MemoryRegion_t* pRegion = find_region(nAddr);
+
+	return pRegion ? pRegion->prot : -1;
+}
 
-	uint8_t* end = (uint8_t*)pPatchAddress + iPatchSize;
-	uintptr_t align_size = end - align_addr;
+struct MemoryWrite_t
+{
+	uint8_t* pAddress;
+	std::vector<uint8_t> patch;
+};
 
-	int result = mprotect(align_addr, align_size, PROT_READ | PROT_WRITE);
+struct Page_t
+{
+	uintptr_t nAddr;
+	int prot;
+};
 
-	memcpy(pPatchAddress, pPatch, iPatchSize);
+static int g_iMemoryWriteBatchDepth = 0;
+static std::vector<MemoryWrite_t> g_vecQueuedMemoryWrites;
+
+// Adds every page the write touches, false if any of them isn't in the parsed map
+static bool add_pages(const MemoryWrite_t& write, uintptr_t page_size, std::vector<Page_t>& pages)
+{
+	uintptr_t nStart = (uintptr_t)write.pAddress & ~(page_size - 1);
+	uintptr_t nEnd = (uintptr_t)write.pAddress + write.patch.size();
+
+	for (uintptr_t nPage = nStart; nPage < nEnd; nPage += page_size)
+	{
+		int prot = get_prot(nPage);
 
-	result = mprotect(align_addr, align_size, old_prot);
+		if (prot == -1)
+			return false;
+
+		pages.push_back({nPage, prot});
+	}
+
+	return true;
 }
 
-void* CModule::FindVirtualTable(const std::string& name)
+// Makes every page the writes touch writable once, in runs of adjacent pages with the same protection, and restores them after.
+// Writes that wouldn't change anything, like repeating a patch, are dropped, but only once their pages are known to be readable
+static void write_memory(const std::vector<MemoryWrite_t>& writes, bool bReparse)
 {
-	auto readOnlyData = GetSection(".rodata");
-	auto readOnlyRelocations = GetSection(".data.rel.ro");
+	uintptr_t page_size = sysconf(_SC_PAGESIZE);
 
-	if (!readOnlyData || !readOnlyRelocations)
+	if (bReparse || g_vecMemoryRegions.empty())
 	{
-		Warning("Failed to find .rodata or .data.rel.ro section\n");
-		return nullptr;
+		parse_regions();
+		bReparse = true;
 	}
 
-	std::string decoratedTableName = std::to_string(name.length()) + name;
+	std::vector<Page_t> pages;
+	std::vector<const MemoryWrite_t*> pendingWrites;
 
-	SignatureIterator sigIt(readOnlyData->m_pBase, readOnlyData->m_iSize, (const byte*)decoratedTableName.c_str(), decoratedTableName.size() + 1);
-	void* classNameString = sigIt.FindNext(false);
+	// False if a page wasn't in the map and it wasn't just parsed
+	auto findPendingWrites = [&](bool bParsed) {
+		pages.clear();
+		pendingWrites.clear();
 
-	if (!classNameString)
+		for (const MemoryWrite_t& write : writes)
+		{
+			if (write.patch.empty())
+				continue;
+
+			size_t nFirstPage = pages.size();
+
+			if (!add_pages(write, page_size, pages))
+			{
+				if (!bParsed)
+					return false;
+
+				Warning("Tried to write %zu bytes to unmapped memory at %p\n", write.patch.size(), write.pAddress);
+				pages.resize(nFirstPage);
+				continue;
+			}
+
+			bool bReadable = std::all_of(pages.begin() + nFirstPage, pages.end(), [](const Page_t& page) { return page.prot & PROT_READ; });
+
+			if (bReadable && !memcmp(write.pAddress, write.patch.data(), write.patch.size()))
+			{
+				pages.resize(nFirstPage);
+				continue;
+			}
+
+			pendingWrites.push_back(&write);
+		}
+
+		return true;
+	};
+
+	// Mapped after the last parse, start over with the current map so every page agrees with it
+	if (!findPendingWrites(bReparse))
 	{
-		Warning("Failed to find type descriptor for %s\n", name.c_str());
-		return nullptr;
+		parse_regions();
+		findPendingWrites(true);
 	}
 
-	SignatureIterator sigIt2(readOnlyRelocations->m_pBase, readOnlyRelocations->m_iSize, (const byte*)&classNameString, sizeof(void*));
-	void* typeName = sigIt2.FindNext(false);
+	if (pendingWrites.empty())
+		return;
 
-	if (!typeName)
+	std::sort(pages.begin(), pages.end(), [](const Page_t& a, const Page_t& b) { return a.nAddr < b.nAddr; });
+	pages.erase(std::unique(pages.begin(), pages.end(), [](const Page_t& a, const Page_t& b) { return a.nAddr == b.nAddr; }), pages.end());
+
+	struct PageRun_t
 	{
-		Warning("Failed to find type name for %s\n", name.c_str());
-		return nullptr;
+		uintptr_t nAddr;
+		size_t nSize;
+		int prot;
+	};
+
+	std::vector<PageRun_t> runs;
+
+	for (const Page_t& page : pages)
+	{
+		if (!runs.empty() && runs.back().nAddr + runs.back().nSize == page.nAddr && runs.back().prot == page.prot)
+			runs.back().nSize += page_size;
+		else
+			runs.push_back({page.nAddr, page_size, page.prot});
+	}
+
+	for (const PageRun_t& run : runs)
+		mprotect((void*)run.nAddr, run.nSize, PROT_READ | PROT_WRITE);
+
+	for (const MemoryWrite_t* write : pendingWrites)
+		memcpy(write->pAddress, write->patch.data(), write->patch.size());
+
+	for (const PageRun_t& run : runs)
+		mprotect((void*)run.nAddr, run.nSize, run.prot);
+}
+
+void Plat_WriteMemory(void* pPatchAddress, uint8_t* pPatch, int iPatchSize)
+{
+	MemoryWrite_t write;
+	write.pAddress = (uint8_t*)pPatchAddress;
+	write.patch.assign(pPatch, pPatch + iPatchSize);
+
+	if (g_iMemoryWriteBatchDepth > 0)
+		g_vecQueuedMemoryWrites.push_back(std::move(write));
+	else
+		write_memory({std::move(write)}, false);
+}
+
+CMemoryWriteBatch::CMemoryWriteBatch()
+{
+	g_iMemoryWriteBatchDepth++;
+}
+
+CMemoryWriteBatch::~CMemoryWriteBatch()
+{
+	if (--g_iMemoryWriteBatchDepth > 0)
+		return;
+
+	std::vector<MemoryWrite_t> writes = std::move(g_vecQueuedMemoryWrites);
+	g_vecQueuedMemoryWrites.clear();
+
+	// Batches are rare and write a lot, so they always start from the current protections
+	write_memory(writes, true);
+}
+
+struct BuildIdSearch
+{
+	uintptr_t base;	   // in
+	std::string hexId; // out
+};
+
+static int FindBuildIdCallback(dl_phdr_info* info, size_t size, void* data)
+{
+	BuildIdSearch* search = static_cast<BuildIdSearch*>(data);
+
+	if (info->dlpi_addr != search->base)
+		return 0;
+
+	for (int i = 0; i < info->dlpi_phnum; i++)
+	{
+		const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+
+		if (phdr.p_type != PT_NOTE)
+			continue;
+
+		uintptr_t note = info->dlpi_addr + phdr.p_vaddr;
+		uintptr_t end = note + phdr.p_memsz;
+
+		while (note + sizeof(ElfW(Nhdr)) <= end)
+		{
+			ElfW(Nhdr)* nhdr = reinterpret_cast<ElfW(Nhdr)*>(note);
+			const char* name = reinterpret_cast<const char*>(note + sizeof(ElfW(Nhdr)));
+			const uint8_t* desc = reinterpret_cast<const uint8_t*>(name + ((nhdr->n_namesz + 3) & ~3));
+
+			if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == 4 && !memcmp(name, "GNU", 4))
+			{
+				char hex[3];
+
+				for (ElfW(Word) j = 0; j < nhdr->n_descsz; j++)
+				{
+					snprintf(hex, sizeof(hex), "%02x", desc[j]);
+					search->hexId += hex;
+				}
+
+				return 1;
+			}
+
+			note = reinterpret_cast<uintptr_t>(desc) + ((nhdr->n_descsz + 3) & ~3);
+		}
+	}
+
+	return 1;
+}
+
+std::string CModule::GetBuildId()
+{
+	link_map* lmap;
+	if (dlinfo(m_hModule, RTLD_DI_LINKMAP, &lmap) != 0)
+		return "";
+
+	BuildIdSearch search;
+	search.base = lmap->l_addr;
+	dl_iterate_phdr(FindBuildIdCallback, &search);
+
+	return search.hexId;
+}
+
+static bool IsIdentifierChar(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Type names are mangled, "<length><name>" for classes in the global namespace which are indexed by just the name,
+// nested names "N...E" are indexed as they are. Anything else isn't a type name
+static bool ParseTypeName(const char* pszName, size_t iMaxLength, std::string& name)
+{
+	size_t iLength = strnlen(pszName, iMaxLength);
+
+	if (iLength == iMaxLength || iLength < 2)
+		return false;
+
+	for (size_t i = 0; i < iLength; i++)
+		if (!IsIdentifierChar(pszName[i]))
+			return false;
+
+	if (pszName[0] == 'N' && pszName[iLength - 1] == 'E')
+	{
+		name.assign(pszName, iLength);
+		return true;
 	}
 
-	void* typeInfo = (void*)((uintptr_t)typeName - 0x8);
+	size_t iDigits = 0;
+	size_t iNameLength = 0;
+
+	while (iDigits < iLength && pszName[iDigits] >= '0' && pszName[iDigits] <= '9')
+		iNameLength = iNameLength * 10 + (pszName[iDigits++] - '0');
+
+	if (iDigits == 0 || iNameLength != iLength - iDigits)
+		return false;
+
+	name.assign(pszName + iDigits, iNameLength);
+	return true;
+}
+
+// Walks the relocated read only data twice instead of once per class: first for type infos, which are a vtable
+// pointer followed by a pointer to the type name in .rodata, then for vtables, whose type info slot comes after a 0 offset to top
+void CModule::IndexVirtualTables()
+{
+	m_bVirtualTablesIndexed = true;
+
+	auto readOnlyData = GetSection(".rodata");
+	auto readOnlyRelocations = GetSection(".data.rel.ro");
+
+	if (!readOnlyData || !readOnlyRelocations)
+		return; // FindVirtualTable reports every class as missing
+
+	uintptr_t nameStart = (uintptr_t)readOnlyData->m_pBase;
+	uintptr_t nameEnd = nameStart + readOnlyData->m_iSize;
+
+	auto forEachSlot = [](Section* section, auto&& func) {
+		uintptr_t start = ((uintptr_t)section->m_pBase + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
+		uintptr_t end = (uintptr_t)section->m_pBase + section->m_iSize;
+
+		for (uintptr_t slot = start + sizeof(uintptr_t); slot + sizeof(uintptr_t) <= end; slot += sizeof(uintptr_t))
+			func((uintptr_t*)slot);
+	};
+
+	// The first type info pointing to each name, like the old per-class search
+	std::unordered_map<std::string, uintptr_t> typeInfoByName;
+	std::string name;
+
+	forEachSlot(readOnlyRelocations, [&](uintptr_t* slot) {
+		uintptr_t pName = *slot;
+
+		if (pName < nameStart || pName >= nameEnd || !slot[-1])
+			return;
+
+		if (ParseTypeName((const char*)pName, nameEnd - pName, name))
+			typeInfoByName.try_emplace(name, (uintptr_t)(slot - 1));
+	});
+
+	std::unordered_map<uintptr_t, const std::string*> nameByTypeInfo;
+	uintptr_t minTypeInfo = UINTPTR_MAX;
+	uintptr_t maxTypeInfo = 0;
+
+	for (const auto& [typeName, typeInfo] : typeInfoByName)
+	{
+		nameByTypeInfo[typeInfo] = &typeName;
+		minTypeInfo = std::min(minTypeInfo, typeInfo);
+		maxTypeInfo = std::max(maxTypeInfo, typeInfo);
+	}
 
 	for (const auto& sectionName : {std::string_view(".data.rel.ro"), std::string_view(".data.rel.ro.local")})
 	{
@@ -244,14 +528,17 @@ void* CModule::FindVirtualTable(const std::string& name)
 		if (!section)
 			continue;
 
-		SignatureIterator sigIt3(section->m_pBase, section->m_iSize, (const byte*)&typeInfo, sizeof(void*));
+		forEachSlot(section, [&](uintptr_t* slot) {
+			uintptr_t typeInfo = *slot;
 
-		while (void* vtable = sigIt3.FindNext(false))
-			if (*(int64_t*)((uintptr_t)vtable - 0x8) == 0)
-				return (void*)((uintptr_t)vtable + 0x8);
-	}
+			if (typeInfo < minTypeInfo || typeInfo > maxTypeInfo || slot[-1] != 0)
+				return;
 
-	Warning("Failed to find vtable for %s\n", name.c_str());
-	return nullptr;
+			auto it = nameByTypeInfo.find(typeInfo);
+
+			if (it != nameByTypeInfo.end())
+				m_umVirtualTables.try_emplace(*it->second, (void*)(slot + 1));
+		});
+	}
 }
 #endif
@@ -22,12 +22,128 @@
 
 #include "module.h"
 #include "plat.h"
+#include <algorithm>
 
 #include "tier0/memdbgon.h"
 
+struct MemoryWrite_t
+{
+	uint8_t* pAddress;
+	std::vector<uint8_t> patch;
+};
+
+static int g_iMemoryWriteBatchDepth = 0;
+static std::vector<MemoryWrite_t> g_vecQueuedMemoryWrites;
+
+// Makes the pages the writes touch writable once, one VirtualProtect per run of adjacent pages with the same protection
+static void WriteMemory(const std::vector<MemoryWrite_t>& writes)
+{
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	uintptr_t pageSize = sysInfo.dwPageSize;
+
+	std::vector<uintptr_t> pages;
+
+	for (const MemoryWrite_t& write : writes)
+		for (uintptr_t page = (uintptr_t)write.pAddress & ~(pageSize - 1); page < (uintptr_t)write.pAddress + write.patch.size(); page += pageSize)
+			pages.push_back(page);
+
+	std::sort(pages.begin(), pages.end());
+	pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+	struct PageRun_t
+	{
+		uintptr_t address;
+		size_t size;
+		DWORD oldProtect;
+	};
+
+	std::vector<PageRun_t> runs;
+
+	for (size_t i = 0; i < pages.size();)
+	{
+		MEMORY_BASIC_INFORMATION mbi;
+		if (!VirtualQuery((void*)pages[i], &mbi, sizeof(mbi)))
+		{
+			i++;
+			continue;
+		}
+
+		// Pages in the same region have the same protection
+		uintptr_t regionEnd = (uintptr_t)mbi.BaseAddress + mbi.RegionSize;
+		size_t first = i++;
+
+		while (i < pages.size() && pages[i] == pages[i - 1] + pageSize && pages[i] < regionEnd)
+			i++;
+
+		PageRun_t run = {pages[first], (i - first) * pageSize, 0};
+
+		if (VirtualProtect((void*)run.address, run.size, PAGE_EXECUTE_READWRITE, &run.oldProtect))
+			runs.push_back(run);
+	}
+
+	auto isWritable = [&](uintptr_t start, uintptr_t end) {
+		for (const PageRun_t& run : runs)
+		{
+			if (start >= end)
+				break;
+
+			if (start >= run.address && start < run.address + run.size)
+				start = run.address + run.size;
+		}
+
+		return start >= end;
+	};
+
+	for (const MemoryWrite_t& write : writes)
+	{
+		// Let WriteProcessMemory fail on anything that couldn't be made writable instead of crashing
+		if (!isWritable((uintptr_t)write.pAddress, (uintptr_t)write.pAddress + write.patch.size()))
+		{
+			WriteProcessMemory(GetCurrentProcess(), write.pAddress, write.patch.data(), write.patch.size(), nullptr);
+			continue;
+		}
+
+		memcpy(write.pAddress, write.patch.data(), write.patch.size());
+		FlushInstructionCache(GetCurrentProcess(), write.pAddress, write.patch.size());
+	}
+
+	for (const PageRun_t& run : runs)
+	{
+		DWORD oldProtect;
+		VirtualProtect((void*)run.address, run.size, run.oldProtect, &oldProtect);
+	}
+}
+
 void Plat_WriteMemory(void* pPatchAddress, uint8_t* pPatch, int iPatchSize)
 {
-	WriteProcessMemory(GetCurrentProcess(), pPatchAddress, (void*)pPatch, iPatchSize, nullptr);
+	if (g_iMemoryWriteBatchDepth == 0)
+	{
+		WriteProcessMemory(GetCurrentProcess(), pPatchAddress, (void*)pPatch, iPatchSize, nullptr);
+		return;
+	}
+
+	MemoryWrite_t write;
+	write.pAddress = (uint8_t*)pPatchAddress;
+	write.patch.assign(pPatch, pPatch + iPatchSize);
+
+	g_vecQueuedMemoryWrites.push_back(std::move(write));
+}
+
+CMemoryWriteBatch::CMemoryWriteBatch()
+{
+	g_iMemoryWriteBatchDepth++;
+}
+
+CMemoryWriteBatch::~CMemoryWriteBatch()
+{
+	if (--g_iMemoryWriteBatchDepth > 0)
+		return;
+
+	std::vector<MemoryWrite_t> writes = std::move(g_vecQueuedMemoryWrites);
+	g_vecQueuedMemoryWrites.clear();
+
+	WriteMemory(writes);
 }
 
 void CModule::InitializeSections()
@@ -48,59 +164,98 @@ void CModule::InitializeSections()
 	}
 }
 
-void* CModule::FindVirtualTable(const std::string& name)
+// The PDB signature the linker writes into the CodeView debug entry, falls back to the link timestamp and image size
+std::string CModule::GetBuildId()
 {
-	auto runTimeData = GetSection(".data");
-	auto readOnlyData = GetSection(".rdata");
+	IMAGE_DOS_HEADER* pDosHeader = reinterpret_cast<IMAGE_DOS_HEADER*>(m_hModule);
+	IMAGE_NT_HEADERS* pNtHeader = reinterpret_cast<IMAGE_NT_HEADERS64*>(reinterpret_cast<uintptr_t>(m_hModule) + pDosHeader->e_lfanew);
+	IMAGE_DATA_DIRECTORY& debugDir = pNtHeader->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG];
 
-	if (!runTimeData || !readOnlyData)
+	char szBuildId[64];
+
+	IMAGE_DEBUG_DIRECTORY* pDebug = reinterpret_cast<IMAGE_DEBUG_DIRECTORY*>(reinterpret_cast<uintptr_t>(m_hModule) + debugDir.VirtualAddress);
+
+	for (DWORD i = 0; debugDir.VirtualAddress && i < debugDir.Size / sizeof(IMAGE_DEBUG_DIRECTORY); i++)
 	{
-		Warning("Failed to find .data or .rdata section\n");
-		return nullptr;
-	}
+		if (pDebug[i].Type != IMAGE_DEBUG_TYPE_CODEVIEW || pDebug[i].SizeOfData < 24)
+			continue;
 
-	std::string decoratedTableName = ".?AV" + name + "@@";
+		const uint8_t* pCodeView = reinterpret_cast<const uint8_t*>(reinterpret_cast<uintptr_t>(m_hModule) + pDebug[i].AddressOfRawData);
 
-	SignatureIterator sigIt(runTimeData->m_pBase, runTimeData->m_iSize, (const byte*)decoratedTableName.c_str(), decoratedTableName.size() + 1);
-	void* typeDescriptor = sigIt.FindNext(false);
+		if (memcmp(pCodeView, "RSDS", 4))
+			continue;
 
-	if (!typeDescriptor)
-	{
-		Warning("Failed to find type descriptor for %s\n", name.c_str());
-		return nullptr;
+		// GUID followed by the age
+		for (int j = 0; j < 20; j++)
+			V_snprintf(szBuildId + j * 2, sizeof(szBuildId) - j * 2, "%02x", pCodeView[4 + j]);
+
+		return szBuildId;
 	}
 
-	typeDescriptor = (void*)((uintptr_t)typeDescriptor - 0x10);
+	V_snprintf(szBuildId, sizeof(szBuildId), "%08lx%08lx", pNtHeader->FileHeader.TimeDateStamp, pNtHeader->OptionalHeader.SizeOfImage);
 
-	const uint32_t rttiTDRva = (uintptr_t)typeDescriptor - (uintptr_t)m_base;
+	return szBuildId;
+}
 
-	ConMsg("RTTI Type Descriptor RVA: 0x%p\n", rttiTDRva);
+// One pass over .rdata for the complete object locators of primary vtables, which point to their type descriptor
+// in .data and back to themselves, then one for the vtables, which come right after a pointer to their locator
+void CModule::IndexVirtualTables()
+{
+	m_bVirtualTablesIndexed = true;
+
+	auto runTimeData = GetSection(".data");
+	auto readOnlyData = GetSection(".rdata");
+
+	if (!runTimeData || !readOnlyData)
+		return; // FindVirtualTable reports every class as missing
+
+	uintptr_t base = (uintptr_t)m_base;
+	uintptr_t dataStart = (uintptr_t)runTimeData->m_pBase - base;
+	uintptr_t dataEnd = dataStart + runTimeData->m_iSize;
+	uintptr_t readOnlyStart = (uintptr_t)readOnlyData->m_pBase;
+	uintptr_t readOnlyEnd = readOnlyStart + readOnlyData->m_iSize;
 
-	SignatureIterator sigIt2(readOnlyData->m_pBase, readOnlyData->m_iSize, (const byte*)&rttiTDRva, sizeof(uint32_t));
+	std::unordered_map<uintptr_t, std::string> nameByLocator;
+	uintptr_t minLocator = UINTPTR_MAX;
+	uintptr_t maxLocator = 0;
 
-	while (void* completeObjectLocator = sigIt2.FindNext(false))
+	for (uintptr_t locator = readOnlyStart; locator + 0x18 <= readOnlyEnd; locator += sizeof(int32_t))
 	{
-		auto completeObjectLocatorHeader = (uintptr_t)completeObjectLocator - 0xC;
-		// check RTTI Complete Object Locator header, always 0x1
-		if (*(int32_t*)(completeObjectLocatorHeader) != 1)
+		const int32_t* pLocator = (const int32_t*)locator;
+
+		// Header is always 0x1, then the vtable offset, and the locator's own RVA last
+		if (pLocator[0] != 1 || pLocator[1] != 0 || (uint32_t)pLocator[5] != locator - base)
 			continue;
 
-		// check RTTI Complete Object Locator vtable offset
-		if (*(int32_t*)((uintptr_t)completeObjectLocator - 0x8) != 0)
+		// The decorated name comes after the type descriptor's vtable pointer and spare field
+		uintptr_t nameRva = (uint32_t)pLocator[3] + 0x10;
+
+		if (nameRva < dataStart + 0x10 || nameRva >= dataEnd)
 			continue;
 
-		SignatureIterator sigIt3(readOnlyData->m_pBase, readOnlyData->m_iSize, (const byte*)&completeObjectLocatorHeader, sizeof(void*));
-		void* vtable = sigIt3.FindNext(false);
+		const char* pszName = (const char*)(base + nameRva);
+		size_t iLength = strnlen(pszName, dataEnd - nameRva);
 
-		if (!vtable)
-		{
-			Warning("Failed to find vtable for %s\n", name.c_str());
-			return nullptr;
-		}
+		if (iLength == dataEnd - nameRva || iLength < 6 || strncmp(pszName, ".?AV", 4) || strcmp(pszName + iLength - 2, "@@"))
+			continue;
 
-		return (void*)((uintptr_t)vtable + 0x8);
+		nameByLocator[locator].assign(pszName + 4, iLength - 6);
+		minLocator = std::min(minLocator, locator);
+		maxLocator = std::max(maxLocator, locator);
 	}
 
-	Warning("Failed to find RTTI Complete Object Locator for %s\n", name.c_str());
-	return nullptr;
-}
\ No newline at end of file
+	uintptr_t slotStart = (readOnlyStart + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
+
+	for (uintptr_t slot = slotStart; slot + sizeof(uintptr_t) <= readOnlyEnd; slot += sizeof(uintptr_t))
+	{
+		uintptr_t locator = *(uintptr_t*)slot;
+
+		if (locator < minLocator || locator > maxLocator)
+			continue;
+
+		auto it = nameByLocator.find(locator);
+
+		if (it != nameByLocator.end())
+			m_umVirtualTables.try_emplace(it->second, (void*)(slot + sizeof(uintptr_t)));
+	}
+}
@@ -0,0 +1,293 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "signature_scanner.h"
+#include <algorithm>
+#include <bit>
+#include <emmintrin.h>
+
+#define SIG_WILDCARD 0x2A
+
+int CSignatureScanner::AddSignature(const uint8_t* pSignature, size_t iLength)
+{
+	Signature_t sig;
+	sig.bytes.assign(pSignature, pSignature + iLength);
+	sig.iAnchor = 0;
+	sig.bPairAnchor = false;
+	sig.pFirstMatch = nullptr;
+	sig.nMatches = 0;
+
+	m_vecSignatures.push_back(std::move(sig));
+
+	return m_vecSignatures.size() - 1;
+}
+
+void CSignatureScanner::SelectAnchors(const uint8_t* pBase, size_t iSize)
+{
+	// Sample about 256k positions of the buffer, that's enough to tell rare byte pairs from common ones
+	size_t iStride = 1 + iSize / (1 << 18);
+	std::vector<uint32_t> vecPairCounts(65536);
+	uint32_t byteCounts[256] = {};
+
+	for (size_t i = 0; i + 1 < iSize; i += iStride)
+	{
+		vecPairCounts[pBase[i] | (pBase[i + 1] << 8)]++;
+		byteCounts[pBase[i]]++;
+	}
+
+	for (auto& vecAnchored : m_vecAnchored)
+		vecAnchored.clear();
+
+	m_vecAnchors.clear();
+
+	for (int i = 0; i < Count(); i++)
+	{
+		Signature_t& sig = m_vecSignatures[i];
+		const std::vector<uint8_t>& bytes = sig.bytes;
+
+		// Prefer the rarest pair of adjacent non-wildcard bytes, then the rarest single byte.
+		// Signatures that are only wildcards are checked at every position
+		uint32_t iBestCount = UINT32_MAX;
+		sig.iAnchor = SIZE_MAX;
+		sig.bPairAnchor = false;
+
+		for (size_t j = 0; j + 1 < bytes.size(); j++)
+		{
+			if (bytes[j] == SIG_WILDCARD || bytes[j + 1] == SIG_WILDCARD)
+				continue;
+
+			uint32_t iCount = vecPairCounts[bytes[j] | (bytes[j + 1] << 8)];
+
+			if (iCount < iBestCount)
+			{
+				iBestCount = iCount;
+				sig.iAnchor = j;
+				sig.bPairAnchor = true;
+			}
+		}
+
+		for (size_t j = 0; !sig.bPairAnchor && j < bytes.size(); j++)
+		{
+			if (bytes[j] != SIG_WILDCARD && byteCounts[bytes[j]] < iBestCount)
+			{
+				iBestCount = byteCounts[bytes[j]];
+				sig.iAnchor = j;
+			}
+		}
+
+		if (sig.iAnchor == SIZE_MAX)
+			continue;
+
+		uint8_t first = bytes[sig.iAnchor];
+		uint8_t second = sig.bPairAnchor ? bytes[sig.iAnchor + 1] : 0;
+
+		if (std::find_if(m_vecAnchors.begin(), m_vecAnchors.end(),
+						 [&](const Anchor_t& anchor) { return anchor.first == first && anchor.second == second && anchor.bPair == sig.bPairAnchor; })
+			== m_vecAnchors.end())
+			m_vecAnchors.push_back({first, second, sig.bPairAnchor});
+
+		m_vecAnchored[first].push_back(i);
+	}
+}
+
+void CSignatureScanner::CheckCandidates(size_t iPos, size_t iStart, size_t iEnd, std::vector<Result_t>& results) const
+{
+	for (int i : m_vecAnchored[m_pBase[iPos]])
+	{
+		const Signature_t& sig = m_vecSignatures[i];
+
+		if (iPos < iStart + sig.iAnchor)
+			continue;
+
+		size_t iMatchStart = iPos - sig.iAnchor;
+		size_t iLength = sig.bytes.size();
+
+		if (iMatchStart >= iEnd || iLength > m_iSize - iMatchStart)
+			continue;
+
+		const uint8_t* pData = m_pBase + iMatchStart;
+
+		// Other signatures sharing the first anchor byte usually fail here
+		if (sig.bPairAnchor && pData[sig.iAnchor + 1] != sig.bytes[sig.iAnchor + 1])
+			continue;
+
+		if (!Matches(pData, sig.bytes.data(), iLength))
+			continue;
+
+		// The anchor is at a fixed offset in the signature, so the first match seen is the lowest address
+		Result_t& result = results[i];
+
+		if (result.nMatches++ == 0)
+			result.pFirstMatch = pData;
+		else
+			result.nMatches = 2;
+	}
+}
+
+void CSignatureScanner::Scan(const void* pBase, size_t iSize)
+{
+	std::vector<Result_t> results;
+
+	Prepare(pBase, iSize);
+	ScanRange(0, iSize, results);
+	AddResults(results);
+}
+
+void CSignatureScanner::Prepare(const void* pBase, size_t iSize)
+{
+	m_pBase = (const uint8_t*)pBase;
+	m_iSize = iSize;
+
+	for (Signature_t& sig : m_vecSignatures)
+	{
+		sig.pFirstMatch = nullptr;
+		sig.nMatches = 0;
+	}
+
+	SelectAnchors(m_pBase, iSize);
+
+	// Signatures with nothing to anchor on are only wildcards, they match anywhere they fit
+	for (Signature_t& sig : m_vecSignatures)
+	{
+		if (sig.iAnchor != SIZE_MAX || sig.bytes.size() > iSize)
+			continue;
+
+		sig.pFirstMatch = m_pBase;
+		sig.nMatches = sig.bytes.size() < iSize ? 2 : 1;
+	}
+}
+
+void CSignatureScanner::ScanRange(size_t iStart, size_t iEnd, std::vector<Result_t>& results) const
+{
+	results.assign(m_vecSignatures.size(), {nullptr, 0});
+
+	iEnd = std::min(iEnd, m_iSize);
+
+	if (m_vecAnchors.empty() || iStart >= iEnd)
+		return;
+
+	// Anchors of matches starting near the end of the range come after it
+	size_t iMaxAnchor = 0;
+
+	for (const Signature_t& sig : m_vecSignatures)
+		if (sig.iAnchor != SIZE_MAX)
+			iMaxAnchor = std::max(iMaxAnchor, sig.iAnchor);
+
+	size_t iScanEnd = std::min(iEnd + iMaxAnchor, m_iSize);
+
+	// Compare 16 positions against every anchor at once, pair anchors also compare the next byte by loading the block again one byte later
+	struct AnchorBytes_t
+	{
+		__m128i first;
+		__m128i second;
+	};
+
+	std::vector<AnchorBytes_t> vecPairs;
+	std::vector<AnchorBytes_t> vecSingles;
+
+	for (const Anchor_t& anchor : m_vecAnchors)
+		(anchor.bPair ? vecPairs : vecSingles).push_back({_mm_set1_epi8((char)anchor.first), _mm_set1_epi8((char)anchor.second)});
+
+	size_t i = iStart;
+
+	for (; i < iScanEnd && i + 17 <= m_iSize; i += 16)
+	{
+		__m128i block = _mm_loadu_si128((const __m128i*)(m_pBase + i));
+		__m128i nextBlock = _mm_loadu_si128((const __m128i*)(m_pBase + i + 1));
+		__m128i hits = _mm_setzero_si128();
+
+		for (const AnchorBytes_t& pair : vecPairs)
+			hits = _mm_or_si128(hits, _mm_and_si128(_mm_cmpeq_epi8(block, pair.first), _mm_cmpeq_epi8(nextBlock, pair.second)));
+
+		for (const AnchorBytes_t& single : vecSingles)
+			hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, single.first));
+
+		uint32_t iMask = _mm_movemask_epi8(hits);
+
+		while (iMask)
+		{
+			CheckCandidates(i + std::countr_zero(iMask), iStart, iEnd, results);
+			iMask &= iMask - 1;
+		}
+	}
+
+	for (; i < iScanEnd; i++)
+		if (!m_vecAnchored[m_pBase[i]].empty())
+			CheckCandidates(i, iStart, iEnd, results);
+}
+
+void CSignatureScanner::AddResults(const std::vector<Result_t>& results)
+{
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		Signature_t& sig = m_vecSignatures[i];
+		const Result_t& result = results[i];
+
+		if (result.nMatches == 0)
+			continue;
+
+		if (!sig.pFirstMatch || result.pFirstMatch < sig.pFirstMatch)
+			sig.pFirstMatch = result.pFirstMatch;
+
+		sig.nMatches = std::min(sig.nMatches + result.nMatches, 2);
+	}
+}
+
+void* CSignatureScanner::GetResult(int iIndex, int& error) const
+{
+	const Signature_t& sig = m_vecSignatures[iIndex];
+
+	if (sig.nMatches == 0)
+	{
+		error = SIG_NOT_FOUND;
+		return nullptr;
+	}
+
+	if (sig.nMatches > 1)
+	{
+		error = SIG_FOUND_MULTIPLE;
+		return (void*)sig.pFirstMatch;
+	}
+
+	error = SIG_OK;
+
+	return FollowRelative(sig.pFirstMatch);
+}
+
+bool CSignatureScanner::Matches(const uint8_t* pData, const uint8_t* pSignature, size_t iLength)
+{
+	for (size_t i = 0; i < iLength; i++)
+		if (pData[i] != pSignature[i] && pSignature[i] != SIG_WILDCARD)
+			return false;
+
+	return true;
+}
+
+void* CSignatureScanner::FollowRelative(const uint8_t* pMatch)
+{
+	uint8_t insnByte = *pMatch;
+	if (insnByte == 0xE8 || insnByte == 0xE9)
+	{
+		uintptr_t addr = (uintptr_t)pMatch;
+		int jumpOffset = *(int*)(addr + 1);
+		return (void*)(addr + 5 + jumpOffset);
+	}
+
+	return (void*)pMatch;
+}
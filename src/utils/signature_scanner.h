@@ -0,0 +1,100 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum SigError
+{
+	SIG_OK,
+	SIG_NOT_FOUND,
+	SIG_FOUND_MULTIPLE,
+};
+
+// Finds any number of signatures in a single pass over a buffer, 0x2A bytes in a signature match anything.
+// Each signature is anchored on its rarest pair of adjacent non-wildcard bytes in the scanned buffer (or its rarest byte
+// if it has no such pair), the buffer is searched 16 positions at a time for every anchor at once and only the signatures
+// whose anchor matched are compared in full
+class CSignatureScanner
+{
+public:
+	// Returns the index to get the result with, the signature is copied
+	int AddSignature(const uint8_t* pSignature, size_t iLength);
+	int Count() const { return m_vecSignatures.size(); }
+
+	// Where each signature matched in part of the buffer, indexed like the signatures
+	struct Result_t
+	{
+		const uint8_t* pFirstMatch;
+		int nMatches; // Stops counting at 2
+	};
+
+	// Same as Prepare, ScanRange over the whole buffer and AddResults
+	void Scan(const void* pBase, size_t iSize);
+
+	// After Prepare, ranges of the buffer can be scanned on several threads at once as long as nothing else is called until
+	// they're done, then their results are added back in any order
+	void Prepare(const void* pBase, size_t iSize);
+	void ScanRange(size_t iStart, size_t iEnd, std::vector<Result_t>& results) const;
+	void AddResults(const std::vector<Result_t>& results);
+
+	// Same results as CModule::FindSignature: the first match, relative E8/E9 calls and jumps are followed for a unique match
+	void* GetResult(int iIndex, int& error) const;
+
+	// Where the first match starts, before following calls and jumps
+	const void* GetMatch(int iIndex) const { return m_vecSignatures[iIndex].pFirstMatch; }
+
+	static bool Matches(const uint8_t* pData, const uint8_t* pSignature, size_t iLength);
+
+	// Follows a relative call or jump at pMatch, returns pMatch otherwise
+	static void* FollowRelative(const uint8_t* pMatch);
+
+private:
+	struct Signature_t
+	{
+		std::vector<uint8_t> bytes;
+		size_t iAnchor;
+		bool bPairAnchor; // The byte after the anchor is part of it
+		const uint8_t* pFirstMatch;
+		int nMatches; // Stops counting at 2
+	};
+
+	void SelectAnchors(const uint8_t* pBase, size_t iSize);
+
+	// Only matches starting in [iStart, iEnd) are counted, so each one is found by exactly one range
+	void CheckCandidates(size_t iPos, size_t iStart, size_t iEnd, std::vector<Result_t>& results) const;
+
+	std::vector<Signature_t> m_vecSignatures;
+	const uint8_t* m_pBase = nullptr;
+	size_t m_iSize = 0;
+
+	struct Anchor_t
+	{
+		uint8_t first;
+		uint8_t second;
+		bool bPair;
+	};
+
+	// Distinct anchors, and the signatures anchored on each first byte, filled by SelectAnchors
+	std::vector<Anchor_t> m_vecAnchors;
+	std::vector<int> m_vecAnchored[256];
+};
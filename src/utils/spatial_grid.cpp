@@ -0,0 +1,218 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spatial_grid.h"
+
+static uint32 HashCell(int64 iCell)
+{
+	return (uint32)(((uint64)iCell * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+void CSpatialGrid::Clear()
+{
+	m_vecPoints.clear();
+	m_vecX.clear();
+	m_vecY.clear();
+	m_vecZ.clear();
+	m_vecCells.clear();
+	m_iCellMask = 0;
+	m_iMinX = m_iMinY = 0;
+	m_iMaxX = m_iMaxY = -1;
+}
+
+void CSpatialGrid::Add(int iIndex, const Vector& vecOrigin)
+{
+	m_vecPoints.push_back({0, iIndex, vecOrigin.x, vecOrigin.y, vecOrigin.z});
+}
+
+void CSpatialGrid::Build()
+{
+	m_vecCells.clear();
+	m_iMinX = m_iMinY = INT_MAX;
+	m_iMaxX = m_iMaxY = INT_MIN;
+
+	for (Point_t& point : m_vecPoints)
+	{
+		int x = CellCoord(point.x);
+		int y = CellCoord(point.y);
+
+		point.iCell = CellKey(x, y);
+		m_iMinX = std::min(m_iMinX, x);
+		m_iMaxX = std::max(m_iMaxX, x);
+		m_iMinY = std::min(m_iMinY, y);
+		m_iMaxY = std::max(m_iMaxY, y);
+	}
+
+	if (m_vecPoints.empty())
+	{
+		Clear();
+		return;
+	}
+
+	std::sort(m_vecPoints.begin(), m_vecPoints.end(), [](const Point_t& a, const Point_t& b) {
+		return a.iCell < b.iCell;
+	});
+
+	m_vecX.resize(m_vecPoints.size());
+	m_vecY.resize(m_vecPoints.size());
+	m_vecZ.resize(m_vecPoints.size());
+
+	for (int i = 0; i < m_vecPoints.size(); i++)
+	{
+		m_vecX[i] = m_vecPoints[i].x;
+		m_vecY[i] = m_vecPoints[i].y;
+		m_vecZ[i] = m_vecPoints[i].z;
+	}
+
+	// Keep the table at most half full
+	uint32 iSize = 16;
+
+	while (iSize < m_vecPoints.size() * 2)
+		iSize *= 2;
+
+	m_vecCells.assign(iSize, {0, 0, 0});
+	m_iCellMask = iSize - 1;
+
+	for (int i = 0; i < m_vecPoints.size();)
+	{
+		int iStart = i;
+		int64 iCell = m_vecPoints[i].iCell;
+
+		while (i < m_vecPoints.size() && m_vecPoints[i].iCell == iCell)
+			i++;
+
+		uint32 iSlot = HashCell(iCell) & m_iCellMask;
+
+		while (m_vecCells[iSlot].iCount)
+			iSlot = (iSlot + 1) & m_iCellMask;
+
+		m_vecCells[iSlot] = {iCell, iStart, i - iStart};
+	}
+}
+
+const CSpatialGrid::Cell_t* CSpatialGrid::FindCell(int x, int y) const
+{
+	if (m_vecCells.empty())
+		return nullptr;
+
+	int64 iCell = CellKey(x, y);
+
+	for (uint32 iSlot = HashCell(iCell) & m_iCellMask; m_vecCells[iSlot].iCount; iSlot = (iSlot + 1) & m_iCellMask)
+	{
+		if (m_vecCells[iSlot].iCell == iCell)
+			return &m_vecCells[iSlot];
+	}
+
+	return nullptr;
+}
+
+uint64 CSpatialGrid::QueryRangeMask(const Vector& vecCenter, float flRadius) const
+{
+	uint64 iMask = 0;
+
+	ForEachInRange(vecCenter, flRadius, [&iMask](int iIndex, float flDistSqr) {
+		iMask |= 1ull << iIndex;
+	});
+
+	return iMask;
+}
+
+int CSpatialGrid::QueryNearest(const Vector& vecCenter, int k, int* pIndices, float* pDistSqr, float flMaxRadius, int iIgnoreIndex) const
+{
+	if (k <= 0 || m_vecPoints.empty())
+		return 0;
+
+	float flMaxDistSqr = flMaxRadius < sqrtf(FLT_MAX) ? flMaxRadius * flMaxRadius : FLT_MAX;
+	int iFound = 0;
+
+	// Insertion into the sorted results, the farthest one falls off once k were found
+	auto check = [&](const Point_t& point) {
+		if (point.iIndex == iIgnoreIndex)
+			return;
+
+		float dx = point.x - vecCenter.x;
+		float dy = point.y - vecCenter.y;
+		float dz = point.z - vecCenter.z;
+		float flDistSqr = dx * dx + dy * dy + dz * dz;
+
+		if (flDistSqr > flMaxDistSqr || (iFound == k && flDistSqr >= pDistSqr[k - 1]))
+			return;
+
+		int i = iFound < k ? iFound++ : k - 1;
+
+		for (; i > 0 && pDistSqr[i - 1] > flDistSqr; i--)
+		{
+			pDistSqr[i] = pDistSqr[i - 1];
+			pIndices[i] = pIndices[i - 1];
+		}
+
+		pDistSqr[i] = flDistSqr;
+		pIndices[i] = point.iIndex;
+	};
+
+	int cx = CellCoord(vecCenter.x);
+	int cy = CellCoord(vecCenter.y);
+
+	// Walk square rings of cells around the center, starting with the first one that reaches a cell in use.
+	// Points in ring r are more than r - 1 cells away, so stop once that can't beat what was found already
+	int iFirstRing = std::max({m_iMinX - cx, cx - m_iMaxX, m_iMinY - cy, cy - m_iMaxY, 0});
+
+	for (int r = iFirstRing;; r++)
+	{
+		// The previous ring already covered every cell in use
+		if (r > iFirstRing && cx - r < m_iMinX && cx + r > m_iMaxX && cy - r < m_iMinY && cy + r > m_iMaxY)
+			break;
+
+		float flRingDist = (r - 1) * m_flCellSize;
+
+		if (flRingDist > 0.0f && (flRingDist * flRingDist > flMaxDistSqr || (iFound == k && flRingDist * flRingDist > pDistSqr[k - 1])))
+			break;
+
+		if (r == 0)
+		{
+			ForEachInCell(cx, cy, check);
+			continue;
+		}
+
+		int iMinX = std::max(cx - r, m_iMinX);
+		int iMaxX = std::min(cx + r, m_iMaxX);
+		int iMinY = std::max(cy - r + 1, m_iMinY);
+		int iMaxY = std::min(cy + r - 1, m_iMaxY);
+
+		for (int x = iMinX; x <= iMaxX; x++)
+		{
+			if (cy - r >= m_iMinY)
+				ForEachInCell(x, cy - r, check);
+
+			if (cy + r <= m_iMaxY)
+				ForEachInCell(x, cy + r, check);
+		}
+
+		for (int y = iMinY; y <= iMaxY; y++)
+		{
+			if (cx - r >= m_iMinX)
+				ForEachInCell(cx - r, y, check);
+
+			if (cx + r <= m_iMaxX)
+				ForEachInCell(cx + r, y, check);
+		}
+	}
+
+	return iFound;
+}
@@ -0,0 +1,204 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mathlib/vector.h"
+#include "platform.h"
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include <xmmintrin.h>
+
+// Sparse hash grid of points bucketed by their x/y cell, distances are still checked in 3D.
+// Meant to be refilled with Clear, Add and Build whenever the points move, e.g. once per tick for player origins
+class CSpatialGrid
+{
+public:
+	CSpatialGrid(float flCellSize = 512.0f) :
+		m_flCellSize(flCellSize), m_flInvCellSize(1.0f / flCellSize) {}
+
+	// Takes effect on the next Build
+	void SetCellSize(float flCellSize)
+	{
+		m_flCellSize = flCellSize;
+		m_flInvCellSize = 1.0f / flCellSize;
+	}
+
+	float GetCellSize() const { return m_flCellSize; }
+	int Count() const { return m_vecPoints.size(); }
+
+	void Clear();
+	void Add(int iIndex, const Vector& vecOrigin);
+	void Build();
+
+	// Calls func(iIndex, flDistSqr) for every point within flRadius of vecCenter
+	template <typename F>
+	void ForEachInRange(const Vector& vecCenter, float flRadius, F&& func) const;
+
+	// Bits of the points within flRadius of vecCenter, indices must be below 64
+	uint64 QueryRangeMask(const Vector& vecCenter, float flRadius) const;
+
+	// Fills pIndices and pDistSqr with up to k points closest to vecCenter, nearest first, and returns how many were found
+	int QueryNearest(const Vector& vecCenter, int k, int* pIndices, float* pDistSqr, float flMaxRadius = FLT_MAX, int iIgnoreIndex = -1) const;
+
+private:
+	struct Point_t
+	{
+		int64 iCell;
+		int iIndex;
+		float x, y, z;
+	};
+
+	struct Cell_t
+	{
+		int64 iCell;
+		int iStart;
+		int iCount; // 0 for an empty bucket
+	};
+
+	// Clamped so huge query radii can't overflow the cell coordinates
+	int CellCoord(float flCoord) const { return (int)std::clamp(std::floor(flCoord * m_flInvCellSize), -16777216.0f, 16777216.0f); }
+	static int64 CellKey(int x, int y) { return ((int64)x << 32) | (uint32)y; }
+	const Cell_t* FindCell(int x, int y) const;
+
+	template <typename F>
+	void ForEachInCell(int x, int y, F&& func) const;
+
+	// Checks the sorted points [iStart, iEnd) 4 at a time, the rest one by one with the same arithmetic so distances match exactly
+	template <typename F>
+	void CheckPoints(int iStart, int iEnd, const Vector& vecCenter, float flRadiusSqr, F&& func) const;
+
+	float m_flCellSize;
+	float m_flInvCellSize;
+
+	// Points sorted by cell after Build, so each cell is a contiguous run
+	std::vector<Point_t> m_vecPoints;
+
+	// The same points split into coordinates, so CheckPoints can load 4 of each at once
+	std::vector<float> m_vecX;
+	std::vector<float> m_vecY;
+	std::vector<float> m_vecZ;
+
+	// Open addressing table of the non-empty cells, size is a power of 2
+	std::vector<Cell_t> m_vecCells;
+	uint32 m_iCellMask = 0;
+
+	// Cell bounds of all points
+	int m_iMinX = 0;
+	int m_iMaxX = -1;
+	int m_iMinY = 0;
+	int m_iMaxY = -1;
+};
+
+template <typename F>
+void CSpatialGrid::ForEachInCell(int x, int y, F&& func) const
+{
+	const Cell_t* pCell = FindCell(x, y);
+
+	if (!pCell)
+		return;
+
+	for (int i = pCell->iStart; i < pCell->iStart + pCell->iCount; i++)
+		func(m_vecPoints[i]);
+}
+
+template <typename F>
+void CSpatialGrid::CheckPoints(int iStart, int iEnd, const Vector& vecCenter, float flRadiusSqr, F&& func) const
+{
+	int i = iStart;
+
+	// Most cells only hold a point or two when players are spread out, those aren't worth setting up for
+	if (iEnd - iStart >= 4)
+	{
+		__m128 centerX = _mm_set1_ps(vecCenter.x);
+		__m128 centerY = _mm_set1_ps(vecCenter.y);
+		__m128 centerZ = _mm_set1_ps(vecCenter.z);
+		__m128 radiusSqr = _mm_set1_ps(flRadiusSqr);
+
+		for (; i + 4 <= iEnd; i += 4)
+		{
+			__m128 dx = _mm_sub_ps(_mm_loadu_ps(&m_vecX[i]), centerX);
+			__m128 dy = _mm_sub_ps(_mm_loadu_ps(&m_vecY[i]), centerY);
+			__m128 dz = _mm_sub_ps(_mm_loadu_ps(&m_vecZ[i]), centerZ);
+			__m128 distSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+			uint32 iMask = _mm_movemask_ps(_mm_cmple_ps(distSqr, radiusSqr));
+
+			if (!iMask)
+				continue;
+
+			float flDistSqr[4];
+			_mm_storeu_ps(flDistSqr, distSqr);
+
+			for (; iMask; iMask &= iMask - 1)
+			{
+				int j = std::countr_zero(iMask);
+				func(m_vecPoints[i + j].iIndex, flDistSqr[j]);
+			}
+		}
+	}
+
+	for (; i < iEnd; i++)
+	{
+		const Point_t& point = m_vecPoints[i];
+		float dx = point.x - vecCenter.x;
+		float dy = point.y - vecCenter.y;
+		float dz = point.z - vecCenter.z;
+		float flDistSqr = dx * dx + dy * dy + dz * dz;
+
+		if (flDistSqr <= flRadiusSqr)
+			func(point.iIndex, flDistSqr);
+	}
+}
+
+template <typename F>
+void CSpatialGrid::ForEachInRange(const Vector& vecCenter, float flRadius, F&& func) const
+{
+	if (m_vecPoints.empty() || !(flRadius >= 0.0f))
+		return;
+
+	float flRadiusSqr = flRadius * flRadius;
+
+	int iMinX = std::max(CellCoord(vecCenter.x - flRadius), m_iMinX);
+	int iMaxX = std::min(CellCoord(vecCenter.x + flRadius), m_iMaxX);
+	int iMinY = std::max(CellCoord(vecCenter.y - flRadius), m_iMinY);
+	int iMaxY = std::min(CellCoord(vecCenter.y + flRadius), m_iMaxY);
+
+	if (iMinX > iMaxX || iMinY > iMaxY)
+		return;
+
+	// Looking up more cells than there are points is slower than just checking every point
+	if ((int64)(iMaxX - iMinX + 1) * (iMaxY - iMinY + 1) >= (int64)m_vecPoints.size())
+	{
+		CheckPoints(0, m_vecPoints.size(), vecCenter, flRadiusSqr, func);
+		return;
+	}
+
+	for (int x = iMinX; x <= iMaxX; x++)
+	{
+		for (int y = iMinY; y <= iMaxY; y++)
+		{
+			if (const Cell_t* pCell = FindCell(x, y))
+				CheckPoints(pCell->iStart, pCell->iStart + pCell->iCount, vecCenter, flRadiusSqr, func);
+		}
+	}
+}
@@ -0,0 +1,44 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "task_pool.h"
+#include <algorithm>
+
+void CTaskPool::Start(int nMaxThreads)
+{
+	int nThreads = std::clamp((int)std::thread::hardware_concurrency() - 1, 1, std::max(nMaxThreads, 1));
+	nThreads = std::min(nThreads, Count());
+
+	for (int i = 0; i < nThreads; i++)
+		m_vecThreads.emplace_back(&CTaskPool::RunJobs, this);
+}
+
+void CTaskPool::Wait()
+{
+	for (std::thread& thread : m_vecThreads)
+		thread.join();
+
+	m_vecThreads.clear();
+}
+
+void CTaskPool::RunJobs()
+{
+	for (size_t i = m_iNextJob++; i < m_vecJobs.size(); i = m_iNextJob++)
+		m_vecJobs[i]();
+}
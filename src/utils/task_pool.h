@@ -0,0 +1,48 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Runs jobs on a few worker threads while the calling thread keeps going, meant for read only work like scanning modules.
+// Jobs mustn't call into the engine, or write anything another job or the calling thread reads before Wait returns
+class CTaskPool
+{
+public:
+	~CTaskPool() { Wait(); }
+
+	// Jobs added after Start aren't run
+	void Add(std::function<void()> job) { m_vecJobs.push_back(std::move(job)); }
+	int Count() const { return m_vecJobs.size(); }
+
+	// Up to nMaxThreads workers, and fewer on machines without enough cores to leave one for the calling thread
+	void Start(int nMaxThreads = 4);
+	void Wait();
+
+private:
+	void RunJobs();
+
+	std::vector<std::function<void()>> m_vecJobs;
+	std::vector<std::thread> m_vecThreads;
+	std::atomic<size_t> m_iNextJob = 0;
+};
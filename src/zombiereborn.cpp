@@ -496,6 +496,8 @@ void CZRPlayerClassManager::ApplyBaseClass(std::shared_ptr<ZRClass> pClass, CCSP
 	//Color clrRender;
 	//V_StringToColor(pModelEntry->szColor.c_str(), clrRender);
 
+	CNetworkStateChangedBatch batch;
+
 	pPawn->m_iMaxHealth = pClass->iHealth;
 	pPawn->m_iHealth = pClass->iHealth;
 	//pPawn->SetModel(pModelEntry->szModelPath.c_str());
@@ -707,7 +709,11 @@ CZRRegenTimer* CZRRegenTimer::s_vecRegenTimers[MAXPLAYERS];
 
 bool CZRRegenTimer::Execute()
 {
-	CCSPlayerPawn* pPawn = m_hPawnHandle.Get();
+	return Regen(m_hPawnHandle.Get());
+}
+
+bool CZRRegenTimer::Regen(CCSPlayerPawn* pPawn)
+{
 	if (!pPawn || !pPawn->IsAlive())
 		return false;
 
@@ -765,7 +771,14 @@ void CZRRegenTimer::Tick()
 		// Timer execute
 		if (pTimer->m_flLastExecute + pTimer->m_flInterval <= g_flUniversalTime)
 		{
-			pTimer->Execute();
+			// The frame's snapshot usually already has the pawn, saves resolving the handle
+			const PlayerSnapshot_t* pSnapshot = g_playerManager->GetSnapshot(i);
+			CCSPlayerPawn* pPawn = pSnapshot ? pSnapshot->pPlayerPawn : nullptr;
+
+			if (!pPawn || pPawn->GetHandle().ToInt() != pTimer->m_hPawnHandle.ToInt())
+				pPawn = pTimer->m_hPawnHandle.Get();
+
+			pTimer->Regen(pPawn);
 			pTimer->m_flLastExecute = g_flUniversalTime;
 		}
 	}
@@ -924,7 +937,7 @@ void ZR_RespawnAll()
 	if (!GetGlobals())
 		return;
 
-	for (int i = 0; i < GetGlobals()->maxClients; i++)
+	for (int i : PlayerBits(g_playerManager->GetConnectedMask()))
 	{
 		CCSPlayerController* pController = CCSPlayerController::FromSlot(i);
 
@@ -1259,14 +1272,19 @@ void ZR_Infect(CCSPlayerController* pAttackerController, CCSPlayerController* pV
 	if (!pVictimPawn)
 		return;
 
-	// We disabled damage due to the delayed infection, restore
-	pVictimPawn->m_bTakesDamage(true);
+	{
+		// Sends the pawn's changes from the class in one go
+		CNetworkStateChangedBatch batch;
 
-	//ZR_StripAndGiveKnife(pVictimPawn);
+		// We disabled damage due to the delayed infection, restore
+		pVictimPawn->m_bTakesDamage(true);
 
-	ZR_StripAndGiveKnife(pVictimPawn);
+		//ZR_StripAndGiveKnife(pVictimPawn);
+
+		ZR_StripAndGiveKnife(pVictimPawn);
 
-	g_pZRPlayerClassManager->ApplyPreferredOrDefaultZombieClass(pVictimPawn);
+		g_pZRPlayerClassManager->ApplyPreferredOrDefaultZombieClass(pVictimPawn);
+	}
 
 	// ZR_InfectShake(pVictimController);
 
@@ -1371,7 +1389,7 @@ void ZR_InitialInfection()
 
 	// mz infection candidates
 	CUtlVector<CCSPlayerController*> pCandidateControllers;
-	for (int i = 0; i < GetGlobals()->maxClients; i++)
+	for (int i : PlayerBits(g_playerManager->GetConnectedMask()))
 	{
 		if (motherZombiesBlackList[i]) { continue; } // 黑名单
 
@@ -1463,7 +1481,7 @@ void ZR_InitialInfection()
 	}
 
 	// reduce everyone's immunity except mz
-	for (int i = 0; i < GetGlobals()->maxClients; i++)
+	for (int i : PlayerBits(g_playerManager->GetConnectedMask()))
 	{
 		ZEPlayer* pPlayer = g_playerManager->GetPlayer(i);
 		if (!pPlayer || vecIsMZ[i])
@@ -1766,13 +1784,12 @@ void ZR_OnRoundTimeWarning(IGameEvent* pEvent)
 // check whether players on a team are all dead
 bool ZR_IsTeamAlive(int iTeamNum)
 {
-	CCSPlayerPawn* pPawn = nullptr;
-	while (nullptr != (pPawn = (CCSPlayerPawn*)UTIL_FindEntityByClassname(pPawn, "player")))
+	for (int i : PlayerBits(g_playerManager->GetConnectedMask()))
 	{
-		if (!pPawn->IsAlive())
-			continue;
+		CCSPlayerController* pController = CCSPlayerController::FromSlot(i);
+		CCSPlayerPawn* pPawn = pController ? pController->GetPlayerPawn() : nullptr;
 
-		if (pPawn->m_iTeamNum() == iTeamNum)
+		if (pPawn && pPawn->IsAlive() && pPawn->m_iTeamNum() == iTeamNum)
 			return true;
 	}
 	return false;
@@ -1799,24 +1816,11 @@ bool ZR_CheckTeamWinConditions(int iTeamNum)
 // ct: ct win, add ct score
 void ZR_EndRoundAndAddTeamScore(int iTeamNum)
 {
-	bool bServerIdle = true;
-
 	if (!GetGlobals() || !g_pGameRules)
 		return;
 
-	for (int i = 0; i < GetGlobals()->maxClients; i++)
-	{
-		ZEPlayer* pPlayer = g_playerManager->GetPlayer(i);
-
-		if (!pPlayer || !pPlayer->IsConnected() || !pPlayer->IsInGame() || pPlayer->IsFakeClient())
-			continue;
-
-		bServerIdle = false;
-		break;
-	}
-
 	// Don't end rounds while the server is idling
-	if (bServerIdle)
+	if (!(g_playerManager->GetInGameMask() & ~g_playerManager->GetFakeClientMask()))
 		return;
 
 	CSRoundEndReason iReason;
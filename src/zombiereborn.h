@@ -231,6 +231,8 @@ public:
 	static void RemoveAllTimers();
 
 private:
+	bool Regen(CCSPlayerPawn* pPawn);
+
 	static double s_flNextExecution;
 	static CZRRegenTimer* s_vecRegenTimers[MAXPLAYERS];
 	int m_iRegenAmount;
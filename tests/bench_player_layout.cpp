@@ -0,0 +1,367 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "harness.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+	#include <linux/perf_event.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+// Cache behaviour of the per-frame player loops with the per-tick state inside ZEPlayer, like before g_playerHotData,
+// against the dense per-slot arrays of PlayerHotData_t. SDK types are replaced by ones of the same size
+
+#define LAYOUT_PLAYERS 64
+
+typedef uint32_t StubHandle;
+
+struct StubColor
+{
+	uint8_t r, g, b, a;
+};
+
+struct StubUtlVector
+{
+	void* pMemory;
+	int iAllocationCount;
+	int iGrowSize;
+	int iSize;
+	void* pElements;
+};
+
+// Field for field the ZEPlayer members from before the hot state moved out
+struct OldZEPlayer_t
+{
+	bool m_bAuthenticated;
+	bool m_bConnected;
+	const void* m_UnauthenticatedSteamID;
+	const void* m_SteamID;
+	int m_slot;
+	bool m_bFakeClient;
+	bool m_bMuted;
+	bool m_bGagged;
+	bool m_bEbanned;
+	uint64_t m_iAdminFlags;
+	int m_iAdminImmunity;
+	int m_iHideDistance;
+	uint32_t m_shouldTransmit[2];
+	int m_iTotalDamage;
+	int m_iTotalHits;
+	int m_iTotalKills;
+	bool m_bVotedRTV;
+	bool m_bHoldingRMB;
+	float m_flRTVVoteTime;
+	bool m_bVotedExtend;
+	bool m_bIsInfected;
+	float m_flExtendVoteTime;
+	int m_iFloodTokens;
+	float m_flLastTalkTime;
+	std::string m_strIp;
+	bool m_bInGame;
+	int m_iMZImmunity;
+	float m_flNominateTime;
+	StubHandle m_hFlashLight;
+	StubHandle m_hBeaconParticle;
+	uint32_t m_iPlayerState;
+	uint32_t m_Handle;
+	bool m_bIsLeader;
+	StubHandle m_handleMark;
+	StubColor m_colorLeader;
+	StubColor m_colorTracer;
+	StubColor m_colorGlow;
+	StubColor m_colorBeacon;
+	StubUtlVector m_vecLeaderVotes;
+	float m_flLeaderVoteTime;
+	StubHandle m_hGlowModel;
+	float m_flSpeedMod;
+	float m_flMaxSpeed;
+	uint64_t m_iLastInputs;
+	std::time_t m_iLastInputTime;
+	std::shared_ptr<void> m_pActiveZRClass;
+	std::shared_ptr<void> m_pActiveZRModel;
+	int m_iButtonWatchMode;
+	StubHandle m_hPointOrient;
+	StubHandle m_hEntwatchHud;
+	int m_iEntwatchHudMode;
+	bool m_bEntwatchClantags;
+	StubColor m_colorEntwatchHud;
+	float m_flEntwatchHudX;
+	float m_flEntwatchHudY;
+	float m_flEntwatchHudSize;
+};
+
+// Same arrays as PlayerHotData_t in playermanager.h
+struct NewHotData_t
+{
+	alignas(64) uint64_t iTransmitBlockMask[LAYOUT_PLAYERS];
+	alignas(64) uint64_t iLastInputs[LAYOUT_PLAYERS];
+	alignas(64) std::time_t iLastInputTime[LAYOUT_PLAYERS];
+	alignas(64) int iHideDistance[LAYOUT_PLAYERS];
+	alignas(64) float flSpeedMod[LAYOUT_PLAYERS];
+	alignas(64) float flMaxSpeed[LAYOUT_PLAYERS];
+	alignas(64) uint32_t iPlayerState[LAYOUT_PLAYERS];
+	alignas(64) StubHandle hFlashLight[LAYOUT_PLAYERS];
+	alignas(64) StubHandle hGlowModel[LAYOUT_PLAYERS];
+	alignas(64) StubHandle hEntwatchHud[LAYOUT_PLAYERS];
+	alignas(64) StubHandle hBeaconParticle[LAYOUT_PLAYERS];
+	alignas(64) bool bHoldingRMB[LAYOUT_PLAYERS];
+	bool bIsLeader[LAYOUT_PLAYERS];
+};
+
+// What the loops get from the snapshot and the pawns, the same for both layouts
+struct FrameInput_t
+{
+	uint64_t iButtons[LAYOUT_PLAYERS];
+	uint64_t iNear[LAYOUT_PLAYERS];
+	std::time_t iNow;
+};
+
+// The reads and writes of CheckHideDistances, UpdatePlayerStates, UpdateIdleTimes and Transmit_GatherScene,
+// returning a checksum so the compiler can't drop any of it
+static uint64_t Layout_RunOld(OldZEPlayer_t** ppPlayers, const FrameInput_t& input)
+{
+	uint64_t iSum = 0;
+
+	for (int i = 0; i < LAYOUT_PLAYERS; i++)
+	{
+		OldZEPlayer_t* pPlayer = ppPlayers[i];
+		pPlayer->m_bHoldingRMB = input.iButtons[i] & 1;
+		uint64_t iMask = pPlayer->m_iHideDistance ? input.iNear[i] : 0;
+		pPlayer->m_shouldTransmit[0] = (uint32_t)iMask;
+		pPlayer->m_shouldTransmit[1] = (uint32_t)(iMask >> 32);
+	}
+
+	for (int i = 0; i < LAYOUT_PLAYERS; i++)
+		iSum += ppPlayers[i]->m_iPlayerState += ppPlayers[i]->m_flSpeedMod < ppPlayers[i]->m_flMaxSpeed;
+
+	for (int i = 0; i < LAYOUT_PLAYERS; i++)
+	{
+		OldZEPlayer_t* pPlayer = ppPlayers[i];
+
+		if (pPlayer->m_iLastInputs != input.iButtons[i])
+		{
+			pPlayer->m_iLastInputs = input.iButtons[i];
+			pPlayer->m_iLastInputTime = input.iNow;
+		}
+
+		iSum += input.iNow - pPlayer->m_iLastInputTime;
+	}
+
+	for (int i = 0; i < LAYOUT_PLAYERS; i++)
+	{
+		const OldZEPlayer_t* pPlayer = ppPlayers[i];
+		iSum += pPlayer->m_bIsLeader + (pPlayer->m_hBeaconParticle != 0) + pPlayer->m_bHoldingRMB;
+		iSum += pPlayer->m_shouldTransmit[0] + ((uint64_t)pPlayer->m_shouldTransmit[1] << 32);
+		iSum += pPlayer->m_hFlashLight + pPlayer->m_hEntwatchHud + pPlayer->m_hGlowModel;
+	}
+
+	return iSum;
+}
+
+static uint64_t Layout_RunNew(NewHotData_t& hot, const FrameInput_t& input)
+{
+	uint64_t iSum = 0;
+
+	for (int i = 0; i < LAYOUT_PLAYERS; i++)
+	{
+		hot.bHoldingRMB[i] = input.iButtons[i] & 1;
+		hot.iTransmitBlockMask[i] = hot.iHideDistance[i] ? input.iNear[i] : 0;
+	}
+
+	for (int i = 0; i < LAYOUT_PLAYERS; i++)
+		iSum += hot.iPlayerState[i] += hot.flSpeedMod[i] < hot.flMaxSpeed[i];
+
+	for (int i = 0; i < LAYOUT_PLAYERS; i++)
+	{
+		if (hot.iLastInputs[i] != input.iButtons[i])
+		{
+			hot.iLastInputs[i] = input.iButtons[i];
+			hot.iLastInputTime[i] = input.iNow;
+		}
+
+		iSum += input.iNow - hot.iLastInputTime[i];
+	}
+
+	for (int i = 0; i < LAYOUT_PLAYERS; i++)
+	{
+		iSum += hot.bIsLeader[i] + (hot.hBeaconParticle[i] != 0) + hot.bHoldingRMB[i];
+		iSum += hot.iTransmitBlockMask[i];
+		iSum += hot.hFlashLight[i] + hot.hEntwatchHud[i] + hot.hGlowModel[i];
+	}
+
+	return iSum;
+}
+
+#ifdef __linux__
+// Hardware counter for this thread, -1 if the kernel or the machine doesn't allow it
+static int Layout_OpenCounter(uint64_t iConfig)
+{
+	perf_event_attr attr{};
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = iConfig;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64_t Layout_ReadCounter(int fd)
+{
+	uint64_t iCount = 0;
+	return fd != -1 && read(fd, &iCount, sizeof(iCount)) == sizeof(iCount) ? iCount : 0;
+}
+#endif
+
+struct LayoutResult_t
+{
+	double flNanoseconds;
+	uint64_t iMisses;
+	uint64_t iReferences;
+};
+
+// Starts every frame from cold caches, like the loops mostly do after a frame's worth of entity thinking
+template <typename P, typename F>
+static LayoutResult_t Layout_Measure(P&& prepare, F&& run, std::vector<uint8_t>& vecFlush, int iFrames, int fdMisses, int fdReferences)
+{
+	LayoutResult_t result{};
+
+	for (int n = 0; n < iFrames; n++)
+	{
+		prepare(n);
+
+		for (size_t i = 0; i < vecFlush.size(); i += 64)
+			vecFlush[i] += n;
+
+#ifdef __linux__
+		uint64_t iMisses = Layout_ReadCounter(fdMisses);
+		uint64_t iReferences = Layout_ReadCounter(fdReferences);
+#endif
+
+		auto start = std::chrono::high_resolution_clock::now();
+		run();
+		auto end = std::chrono::high_resolution_clock::now();
+
+		result.flNanoseconds += std::chrono::duration<double, std::nano>(end - start).count();
+
+#ifdef __linux__
+		result.iMisses += Layout_ReadCounter(fdMisses) - iMisses;
+		result.iReferences += Layout_ReadCounter(fdReferences) - iReferences;
+#endif
+	}
+
+	return result;
+}
+
+void Benchmark_PlayerLayout()
+{
+	const int iFrames = 200;
+	std::mt19937 rng(iFrames);
+
+	// Players connect at different times and in any slot order with other allocations in between, so the old objects end up scattered
+	std::vector<std::unique_ptr<OldZEPlayer_t>> vecOwners;
+	std::vector<std::unique_ptr<uint8_t[]>> vecOther;
+	OldZEPlayer_t* pOldPlayers[LAYOUT_PLAYERS];
+	auto pNew = std::make_unique<NewHotData_t>();
+	auto pInput = std::make_unique<FrameInput_t>();
+	int iConnectOrder[LAYOUT_PLAYERS];
+
+	for (int i = 0; i < LAYOUT_PLAYERS; i++)
+		iConnectOrder[i] = i;
+
+	std::shuffle(iConnectOrder, iConnectOrder + LAYOUT_PLAYERS, rng);
+
+	for (int iSlot : iConnectOrder)
+	{
+		vecOther.emplace_back(new uint8_t[64 + rng() % 4096]);
+		vecOwners.emplace_back(new OldZEPlayer_t{});
+		pOldPlayers[iSlot] = vecOwners.back().get();
+	}
+
+	for (int i = 0; i < LAYOUT_PLAYERS; i++)
+	{
+		pOldPlayers[i]->m_iHideDistance = pNew->iHideDistance[i] = rng() % 2 ? rng() % 1000 : 0;
+		pOldPlayers[i]->m_flSpeedMod = pNew->flSpeedMod[i] = 1.0f;
+		pOldPlayers[i]->m_flMaxSpeed = pNew->flMaxSpeed[i] = 1.0f + (rng() % 2);
+		pOldPlayers[i]->m_bIsLeader = pNew->bIsLeader[i] = rng() % 32 == 0;
+	}
+
+	// Larger than any last level cache
+	std::vector<uint8_t> vecFlush(64 * 1024 * 1024);
+	int fdMisses = -1;
+	int fdReferences = -1;
+
+#ifdef __linux__
+	fdMisses = Layout_OpenCounter(PERF_COUNT_HW_CACHE_MISSES);
+	fdReferences = Layout_OpenCounter(PERF_COUNT_HW_CACHE_REFERENCES);
+#endif
+
+	auto prepare = [&](int n) {
+		pInput->iNow = n / 64;
+
+		for (int i = 0; i < LAYOUT_PLAYERS; i++)
+		{
+			pInput->iButtons[i] = rng() % 4 ? pInput->iButtons[i] : rng();
+			pInput->iNear[i] = ((uint64_t)rng() << 32) | rng();
+		}
+	};
+
+	uint64_t iOldSum = 0;
+	uint64_t iNewSum = 0;
+
+	std::mt19937::result_type iSeed = rng();
+	rng.seed(iSeed);
+	LayoutResult_t old = Layout_Measure(prepare, [&]() { iOldSum += Layout_RunOld(pOldPlayers, *pInput); }, vecFlush, iFrames, fdMisses, fdReferences);
+
+	*pInput = {};
+	rng.seed(iSeed);
+	LayoutResult_t dense = Layout_Measure(prepare, [&]() { iNewSum += Layout_RunNew(*pNew, *pInput); }, vecFlush, iFrames, fdMisses, fdReferences);
+
+	printf("  ZEPlayer fields: %.2f us per frame, %i byte objects\n", old.flNanoseconds / iFrames / 1000.0, (int)sizeof(OldZEPlayer_t));
+	printf("  per-slot arrays: %.2f us per frame, %i bytes in total\n", dense.flNanoseconds / iFrames / 1000.0, (int)sizeof(NewHotData_t));
+
+	if (fdMisses != -1 && fdReferences != -1)
+	{
+		printf("  cache misses per frame: %.1f of %.1f references before, %.1f of %.1f after\n", (double)old.iMisses / iFrames, (double)old.iReferences / iFrames,
+			   (double)dense.iMisses / iFrames, (double)dense.iReferences / iFrames);
+	}
+	else
+	{
+		printf("  hardware cache counters are unavailable, check kernel.perf_event_paranoid\n");
+	}
+
+	if (iOldSum != iNewSum)
+		printf("  the layouts computed different results, the model is out of sync\n");
+
+#ifdef __linux__
+	if (fdMisses != -1)
+		close(fdMisses);
+
+	if (fdReferences != -1)
+		close(fdReferences);
+#endif
+}
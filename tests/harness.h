@@ -0,0 +1,49 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+// Offline checks and benchmarks for the parts of the plugin that don't need the engine.
+// Every test returns how many checks failed, benchmarks only run when asked for since their numbers depend on the machine
+
+#define HARNESS_CHECK(condition, ...)            \
+	do                                           \
+	{                                            \
+		if (!(condition))                        \
+		{                                        \
+			printf("  FAILED %s: ", #condition); \
+			printf(__VA_ARGS__);                 \
+			printf("\n");                        \
+			iFailures++;                         \
+		}                                        \
+	} while (0)
+
+int Test_Transmit();
+void Benchmark_Transmit();
+
+int Test_SpatialGrid();
+void Benchmark_SpatialGrid();
+
+void Benchmark_PlayerLayout();
+
+int Test_SignatureScanner();
+
+int Test_SchemaCache();
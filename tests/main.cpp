@@ -0,0 +1,77 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "harness.h"
+#include <string.h>
+
+struct Suite_t
+{
+	const char* pszName;
+	int (*pfnTest)();
+	void (*pfnBenchmark)();
+};
+
+static const Suite_t g_suites[] = {
+	{"transmit",          Test_Transmit,         Benchmark_Transmit    },
+	{"spatial_grid",      Test_SpatialGrid,      Benchmark_SpatialGrid },
+	{"player_layout",     nullptr,               Benchmark_PlayerLayout},
+	{"signature_scanner", Test_SignatureScanner, nullptr               },
+	{"schema_cache",      Test_SchemaCache,      nullptr               },
+};
+
+// cs2fixes_tests [--benchmark] [suite], exits with 1 if any check failed
+int main(int argc, char** argv)
+{
+	bool bBenchmark = false;
+	const char* pszOnly = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--benchmark"))
+			bBenchmark = true;
+		else
+			pszOnly = argv[i];
+	}
+
+	int iFailures = 0;
+
+	for (const Suite_t& suite : g_suites)
+	{
+		if (pszOnly && strcmp(pszOnly, suite.pszName))
+			continue;
+
+		if (suite.pfnTest)
+		{
+			int iSuiteFailures = suite.pfnTest();
+			printf("%s: %s\n", suite.pszName, iSuiteFailures ? "FAILED" : "ok");
+			iFailures += iSuiteFailures;
+		}
+
+		if (bBenchmark && suite.pfnBenchmark)
+		{
+			// Benchmark only suites don't have a result line to go under
+			if (!suite.pfnTest)
+				printf("%s:\n", suite.pszName);
+
+			suite.pfnBenchmark();
+		}
+	}
+
+	return iFailures ? 1 : 0;
+}
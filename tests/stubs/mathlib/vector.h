@@ -0,0 +1,35 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Stand-in for the SDK's Vector with only the members the files built into cs2fixes_tests use
+
+class Vector
+{
+public:
+	Vector() :
+		x(0.0f), y(0.0f), z(0.0f) {}
+	Vector(float X, float Y, float Z) :
+		x(X), y(Y), z(Z) {}
+
+	float LengthSqr() const { return x * x + y * y + z * z; }
+
+	float x, y, z;
+};
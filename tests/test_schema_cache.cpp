@@ -0,0 +1,194 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cs2_sdk/schema_cache.h"
+#include "harness.h"
+#include <map>
+#include <string.h>
+
+#define SCHEMA_TEST_PATH "cs2fixes_tests_schema_cache.bin"
+
+// Stands in for the schema system, with a few classes made up of generated fields
+class CFakeSchemaProvider : public schema::ISchemaProvider
+{
+public:
+	CFakeSchemaProvider(const char* pszBuildId) :
+		m_buildId(pszBuildId)
+	{
+		for (const char* pszClass : {"CBaseEntity", "CCSPlayerPawn", "CCSPlayerController"})
+		{
+			for (int i = 0; i < 50; i++)
+			{
+				std::string field = std::string(pszClass) + "::m_field" + std::to_string(i);
+				m_classes[pszClass].push_back({hash_32_fnv1a_const(field.c_str()), {i * 8 + (int)strlen(pszClass), i % 3 == 0}});
+			}
+		}
+	}
+
+	bool IsAvailable() override { return true; }
+
+	bool GetClassFields(const char* className, std::vector<std::pair<uint32_t, SchemaKey>>& vecFields) override
+	{
+		m_nLookups++;
+
+		auto it = m_classes.find(className);
+
+		if (it == m_classes.end())
+			return false;
+
+		vecFields.insert(vecFields.end(), it->second.begin(), it->second.end());
+		return true;
+	}
+
+	std::string GetBuildId() override { return m_buildId; }
+
+	std::map<std::string, std::vector<std::pair<uint32_t, SchemaKey>>> m_classes;
+	std::string m_buildId;
+	int m_nLookups = 0;
+};
+
+static std::vector<char> Schema_ReadFile(const char* pszPath)
+{
+	std::vector<char> data;
+	FILE* f = fopen(pszPath, "rb");
+
+	if (!f)
+		return data;
+
+	char buffer[4096];
+	size_t nRead;
+
+	while ((nRead = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		data.insert(data.end(), buffer, buffer + nRead);
+
+	fclose(f);
+	return data;
+}
+
+static void Schema_WriteFile(const char* pszPath, const std::vector<char>& data)
+{
+	FILE* f = fopen(pszPath, "wb");
+
+	if (!f)
+		return;
+
+	fwrite(data.data(), 1, data.size(), f);
+	fclose(f);
+}
+
+// A rejected file must leave nothing behind in the table
+static int Schema_CheckRejected(CFakeSchemaProvider& provider, const std::vector<char>& data, const char* pszBuildId, SchemaCacheError iExpected, const char* pszCase)
+{
+	int iFailures = 0;
+	CSchemaCache cache(&provider);
+
+	Schema_WriteFile(SCHEMA_TEST_PATH, data);
+
+	SchemaCacheError error = cache.Load(SCHEMA_TEST_PATH, pszBuildId);
+	HARNESS_CHECK(error == iExpected, "%s: loading returned %s instead of %s", pszCase, CSchemaCache::GetErrorString(error), CSchemaCache::GetErrorString(iExpected));
+
+	for (const auto& [className, vecFields] : provider.m_classes)
+		HARNESS_CHECK(!cache.HasClass(hash_32_fnv1a_const(className.c_str())), "%s: %s was loaded anyway", pszCase, className.c_str());
+
+	return iFailures;
+}
+
+int Test_SchemaCache()
+{
+	int iFailures = 0;
+	CFakeSchemaProvider provider("0123456789abcdef");
+	CSchemaCache cache(&provider);
+
+	remove(SCHEMA_TEST_PATH);
+	HARNESS_CHECK(cache.Load(SCHEMA_TEST_PATH, provider.GetBuildId()) == SCHEMA_CACHE_MISSING, "loaded a file that doesn't exist");
+
+	for (const auto& [className, vecFields] : provider.m_classes)
+		HARNESS_CHECK(cache.LookUpClass(className.c_str(), hash_32_fnv1a_const(className.c_str())), "%s wasn't found", className.c_str());
+
+	// Classes that don't exist are remembered, but never saved
+	HARNESS_CHECK(!cache.LookUpClass("CMissing", hash_32_fnv1a_const("CMissing")), "a missing class was found");
+	HARNESS_CHECK(cache.HasClass(hash_32_fnv1a_const("CMissing")), "a missing class wasn't remembered");
+	HARNESS_CHECK(cache.IsDirty(), "looking up classes didn't mark the cache dirty");
+
+	HARNESS_CHECK(!cache.Save(SCHEMA_TEST_PATH, std::string(SCHEMA_CACHE_MAX_BUILD_ID, 'a')), "saved with a build id that doesn't fit");
+	HARNESS_CHECK(cache.Save(SCHEMA_TEST_PATH, provider.GetBuildId()), "failed to save to " SCHEMA_TEST_PATH);
+	HARNESS_CHECK(!cache.IsDirty(), "saving didn't clear the dirty flag");
+
+	// Round trip, everything has to come back without asking the provider
+	CSchemaCache loaded(&provider);
+	provider.m_nLookups = 0;
+
+	SchemaCacheError error = loaded.Load(SCHEMA_TEST_PATH, provider.GetBuildId());
+	HARNESS_CHECK(error == SCHEMA_CACHE_OK, "loading what was just saved failed: %s", CSchemaCache::GetErrorString(error));
+	HARNESS_CHECK(!loaded.IsDirty(), "loading marked the cache dirty");
+	HARNESS_CHECK(!loaded.HasClass(hash_32_fnv1a_const("CMissing")), "a missing class was saved");
+
+	int iWrong = 0;
+
+	for (const auto& [className, vecFields] : provider.m_classes)
+	{
+		uint32_t classKey = hash_32_fnv1a_const(className.c_str());
+
+		if (!loaded.HasClass(classKey))
+			iWrong++;
+
+		for (const auto& [memberKey, key] : vecFields)
+		{
+			const SchemaKey* pKey = loaded.FindField(classKey, memberKey);
+
+			if (!pKey || pKey->offset != key.offset || pKey->networked != key.networked)
+				iWrong++;
+		}
+	}
+
+	HARNESS_CHECK(iWrong == 0, "%i classes or fields didn't survive the round trip", iWrong);
+	HARNESS_CHECK(provider.m_nLookups == 0, "the provider was asked for %i classes after loading", provider.m_nLookups);
+
+	std::vector<char> data = Schema_ReadFile(SCHEMA_TEST_PATH);
+	HARNESS_CHECK(!data.empty(), "nothing was written to " SCHEMA_TEST_PATH);
+
+	if (data.empty())
+		return iFailures;
+
+	iFailures += Schema_CheckRejected(provider, data, "fedcba9876543210", SCHEMA_CACHE_BUILD_CHANGED, "different build id");
+	iFailures += Schema_CheckRejected(provider, data, "", SCHEMA_CACHE_BUILD_CHANGED, "empty build id");
+
+	std::vector<char> truncated(data.begin(), data.end() - 1);
+	iFailures += Schema_CheckRejected(provider, truncated, provider.GetBuildId().c_str(), SCHEMA_CACHE_TRUNCATED, "truncated entries");
+
+	truncated.resize(20);
+	iFailures += Schema_CheckRejected(provider, truncated, provider.GetBuildId().c_str(), SCHEMA_CACHE_BAD_HEADER, "truncated header");
+
+	std::vector<char> trailing = data;
+	trailing.push_back(0);
+	iFailures += Schema_CheckRejected(provider, trailing, provider.GetBuildId().c_str(), SCHEMA_CACHE_TRAILING_DATA, "trailing bytes");
+
+	// An offset changed in the last entry
+	std::vector<char> corrupted = data;
+	corrupted[corrupted.size() - 8] ^= 1;
+	iFailures += Schema_CheckRejected(provider, corrupted, provider.GetBuildId().c_str(), SCHEMA_CACHE_CHECKSUM_MISMATCH, "checksum mismatch");
+
+	std::vector<char> badMagic = data;
+	badMagic[0] ^= 1;
+	iFailures += Schema_CheckRejected(provider, badMagic, provider.GetBuildId().c_str(), SCHEMA_CACHE_BAD_HEADER, "bad magic");
+
+	remove(SCHEMA_TEST_PATH);
+
+	return iFailures;
+}
@@ -0,0 +1,206 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "harness.h"
+#include "signature_scanner.h"
+#include <random>
+#include <string.h>
+
+// The first match and how many there are (up to 2), checking every position like CModule::FindSignature used to
+static void Sig_BruteForce(const std::vector<uint8_t>& buffer, const std::vector<uint8_t>& sig, const uint8_t*& pFirstMatch, int& nMatches)
+{
+	pFirstMatch = nullptr;
+	nMatches = 0;
+
+	for (size_t i = 0; i + sig.size() <= buffer.size() && nMatches < 2; i++)
+	{
+		if (!CSignatureScanner::Matches(buffer.data() + i, sig.data(), sig.size()))
+			continue;
+
+		if (nMatches++ == 0)
+			pFirstMatch = buffer.data() + i;
+	}
+}
+
+// Scans the buffer whole and split in ranges at every given point, everything has to agree with brute force
+static int Sig_CheckScan(const std::vector<uint8_t>& buffer, const std::vector<std::vector<uint8_t>>& vecSigs, const std::vector<size_t>& vecSplits, const char* pszCase)
+{
+	int iFailures = 0;
+	CSignatureScanner whole;
+	CSignatureScanner split;
+
+	for (const std::vector<uint8_t>& sig : vecSigs)
+	{
+		whole.AddSignature(sig.data(), sig.size());
+		split.AddSignature(sig.data(), sig.size());
+	}
+
+	whole.Scan(buffer.data(), buffer.size());
+
+	// Added back out of order, like threads finishing
+	split.Prepare(buffer.data(), buffer.size());
+
+	std::vector<std::vector<CSignatureScanner::Result_t>> vecRangeResults(vecSplits.size() + 1);
+
+	for (size_t i = 0; i <= vecSplits.size(); i++)
+		split.ScanRange(i ? vecSplits[i - 1] : 0, i < vecSplits.size() ? vecSplits[i] : buffer.size(), vecRangeResults[i]);
+
+	for (size_t i = vecRangeResults.size(); i-- > 0;)
+		split.AddResults(vecRangeResults[i]);
+
+	for (int i = 0; i < vecSigs.size(); i++)
+	{
+		const uint8_t* pExpected;
+		int nExpected;
+		Sig_BruteForce(buffer, vecSigs[i], pExpected, nExpected);
+
+		for (const CSignatureScanner* pScanner : {&whole, &split})
+		{
+			int error;
+			void* pResult = pScanner->GetResult(i, error);
+			int iExpectedError = nExpected == 0 ? SIG_NOT_FOUND : nExpected == 1 ? SIG_OK : SIG_FOUND_MULTIPLE;
+			void* pExpectedResult = nExpected == 1 ? CSignatureScanner::FollowRelative(pExpected) : (void*)pExpected;
+			const char* pszScan = pScanner == &whole ? "whole" : "split";
+
+			HARNESS_CHECK(pScanner->GetMatch(i) == pExpected, "%s, %s scan: signature %i matched at %td instead of %td", pszCase, pszScan, i,
+						  pScanner->GetMatch(i) ? (const uint8_t*)pScanner->GetMatch(i) - buffer.data() : -1, pExpected ? pExpected - buffer.data() : -1);
+			HARNESS_CHECK(error == iExpectedError, "%s, %s scan: signature %i error %i instead of %i", pszCase, pszScan, i, error, iExpectedError);
+			HARNESS_CHECK(pResult == pExpectedResult, "%s, %s scan: signature %i result %p instead of %p", pszCase, pszScan, i, pResult, pExpectedResult);
+		}
+	}
+
+	return iFailures;
+}
+
+static int Sig_CheckCases()
+{
+	int iFailures = 0;
+
+	// Around 48 xx 89 with other bytes in between, 0x2A in the data is only matched by itself or a wildcard
+	std::vector<uint8_t> buffer(100, 0x90);
+	memcpy(&buffer[40], "\x48\x2A\x89\x5C", 4);
+	memcpy(&buffer[60], "\x48\x11\x89\x5D", 4);
+	iFailures += Sig_CheckScan(buffer, {{0x48, 0x2A, 0x89, 0x5C}, {0x48, 0x2A, 0x89, 0x5D}, {0x2A, 0x2A, 0x89}, {0x11, 0x2A, 0x5D}}, {}, "wildcards");
+
+	// Only wildcards fit anywhere, so they're unique only when they're as long as the buffer
+	iFailures += Sig_CheckScan(buffer, {{0x2A, 0x2A}, std::vector<uint8_t>(buffer.size(), 0x2A), std::vector<uint8_t>(buffer.size() + 1, 0x2A)}, {50}, "only wildcards");
+
+	// A signature overlapping itself in a run of the same byte
+	buffer.assign(100, 0x90);
+	memset(&buffer[30], 0xCC, 4);
+	iFailures += Sig_CheckScan(buffer, {{0xCC, 0xCC, 0xCC}, {0xCC, 0xCC, 0xCC, 0xCC}, {0xCC, 0xCC, 0xCC, 0xCC, 0xCC}, {0x90, 0xCC, 0xCC, 0xCC, 0xCC, 0x90}}, {31, 32}, "overlapping");
+
+	// The same bytes twice, far apart and in different 16 byte blocks
+	buffer.assign(300, 0x00);
+	memcpy(&buffer[5], "\x55\x48\x89\xE5", 4);
+	memcpy(&buffer[250], "\x55\x48\x89\xE5", 4);
+	iFailures += Sig_CheckScan(buffer, {{0x55, 0x48, 0x89, 0xE5}, {0x55, 0x48}, {0x00, 0x55}}, {128}, "multiple matches");
+
+	// Matches right at the start and end of the buffer and straddling every possible split
+	buffer.assign(70, 0x90);
+	memcpy(&buffer[0], "\x41\x57\x41\x56", 4);
+	memcpy(&buffer[33], "\x0F\x1F\x44\x00", 4);
+	memcpy(&buffer[66], "\x5B\x41\x5C\xC3", 4);
+	std::vector<std::vector<uint8_t>> vecBoundarySigs = {{0x41, 0x57, 0x41, 0x56}, {0x0F, 0x1F, 0x44, 0x00}, {0x5B, 0x41, 0x5C, 0xC3}, {0x5C, 0xC3, 0x90}, {0x2A, 0x1F, 0x2A, 0x00}};
+
+	for (size_t iSplit = 0; iSplit <= buffer.size(); iSplit++)
+		iFailures += Sig_CheckScan(buffer, vecBoundarySigs, {iSplit}, "range boundaries");
+
+	iFailures += Sig_CheckScan(buffer, vecBoundarySigs, {1, 2, 3, 34, 35, 36, 67, 68, 69}, "range boundaries");
+
+	// Unique calls and jumps are followed to their target, in both directions
+	buffer.assign(200, 0xCC);
+	int iForward = 100;
+	int iBackward = -60;
+	buffer[20] = 0xE8;
+	memcpy(&buffer[21], &iForward, 4);
+	memcpy(&buffer[25], "\x48\x8B\xF8", 3);
+	buffer[150] = 0xE9;
+	memcpy(&buffer[151], &iBackward, 4);
+	memcpy(&buffer[155], "\x5D\xC3", 2);
+	iFailures += Sig_CheckScan(buffer, {{0xE8, 0x2A, 0x2A, 0x2A, 0x2A, 0x48, 0x8B, 0xF8}, {0xE9, 0x2A, 0x2A, 0x2A, 0x2A, 0x5D, 0xC3}, {0x48, 0x8B}}, {22, 152}, "calls and jumps");
+
+	CSignatureScanner scanner;
+	int iCall = scanner.AddSignature((const uint8_t*)"\xE8\x2A\x2A\x2A\x2A\x48\x8B\xF8", 8);
+	int iJump = scanner.AddSignature((const uint8_t*)"\xE9\x2A\x2A\x2A\x2A\x5D\xC3", 7);
+	scanner.Scan(buffer.data(), buffer.size());
+
+	int error;
+	HARNESS_CHECK(scanner.GetResult(iCall, error) == buffer.data() + 25 + iForward, "call wasn't followed to its target");
+	HARNESS_CHECK(scanner.GetResult(iJump, error) == buffer.data() + 155 + iBackward, "jump wasn't followed to its target");
+
+	// Several calls matching are reported as multiple without following any
+	memcpy(&buffer[100], &buffer[20], 8);
+	scanner.Scan(buffer.data(), buffer.size());
+	HARNESS_CHECK(scanner.GetResult(iCall, error) == buffer.data() + 20 && error == SIG_FOUND_MULTIPLE, "multiple calls were followed");
+
+	return iFailures;
+}
+
+int Test_SignatureScanner()
+{
+	int iFailures = Sig_CheckCases();
+
+	// Few distinct bytes so signatures match often, in overlapping runs and across blocks
+	const uint8_t alphabet[] = {0x00, 0x2A, 0x48, 0x89, 0x8B, 0xE8};
+	std::mt19937 rng(1);
+	std::vector<uint8_t> buffer;
+	std::vector<std::vector<uint8_t>> vecSigs;
+
+	for (int n = 0; n < 300; n++)
+	{
+		buffer.resize(1 + rng() % 400);
+
+		for (uint8_t& byte : buffer)
+			byte = alphabet[rng() % (n % 2 ? 3 : sizeof(alphabet))];
+
+		vecSigs.clear();
+
+		for (int i = 0; i < 12; i++)
+		{
+			// Mostly cut out of the buffer so they're found, the rest made up. Some bytes are turned into wildcards
+			size_t iLength = 1 + rng() % 12;
+			std::vector<uint8_t> sig(iLength);
+
+			if (i % 4 != 0 && iLength <= buffer.size())
+				memcpy(sig.data(), &buffer[rng() % (buffer.size() - iLength + 1)], iLength);
+			else
+				for (uint8_t& byte : sig)
+					byte = alphabet[rng() % sizeof(alphabet)];
+
+			for (uint8_t& byte : sig)
+				if (rng() % 4 == 0)
+					byte = 0x2A;
+
+			vecSigs.push_back(std::move(sig));
+		}
+
+		std::vector<size_t> vecSplits;
+
+		for (size_t iSplit = rng() % 20; iSplit < buffer.size(); iSplit += 1 + rng() % 40)
+			vecSplits.push_back(iSplit);
+
+		iFailures += Sig_CheckScan(buffer, vecSigs, vecSplits, "random");
+
+		if (iFailures)
+			break;
+	}
+
+	return iFailures;
+}
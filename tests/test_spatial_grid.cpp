@@ -0,0 +1,292 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "harness.h"
+#include "spatial_grid.h"
+#include <chrono>
+#include <random>
+
+enum EPointLayout
+{
+	LAYOUT_SPREAD,	   // Over a whole map
+	LAYOUT_CLUSTERED,  // Most players in a few spots, like a ZE defense
+	LAYOUT_COINCIDENT, // Everyone in the same spot, e.g. right after a respawn
+	LAYOUT_FAR,		   // Far away from the origin
+	LAYOUT_COUNT,
+};
+
+static void Grid_RandomPoints(std::vector<Vector>& vecPoints, int nPoints, EPointLayout layout, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> map(-8192.0f, 8192.0f);
+	std::normal_distribution<float> spot(0.0f, 150.0f);
+	Vector vecSpots[4];
+
+	for (Vector& vecSpot : vecSpots)
+		vecSpot = Vector(map(rng), map(rng), map(rng) / 8.0f);
+
+	vecPoints.clear();
+
+	for (int i = 0; i < nPoints; i++)
+	{
+		switch (layout)
+		{
+			case LAYOUT_SPREAD:
+				vecPoints.emplace_back(map(rng), map(rng), map(rng) / 8.0f);
+				break;
+			case LAYOUT_CLUSTERED:
+			{
+				const Vector& vecSpot = vecSpots[rng() % 4];
+				vecPoints.emplace_back(vecSpot.x + spot(rng), vecSpot.y + spot(rng), vecSpot.z + spot(rng) / 4.0f);
+				break;
+			}
+			case LAYOUT_COINCIDENT:
+				vecPoints.push_back(vecSpots[0]);
+				break;
+			default:
+				vecPoints.emplace_back(1000000.0f + map(rng) / 4.0f, -1000000.0f + map(rng) / 4.0f, map(rng));
+				break;
+		}
+	}
+}
+
+// The same arithmetic as the grid, so the results have to match exactly
+static float Grid_DistSqr(const Vector& a, const Vector& b)
+{
+	return Vector(a.x - b.x, a.y - b.y, a.z - b.z).LengthSqr();
+}
+
+static int Grid_CheckRange(const CSpatialGrid& grid, const std::vector<Vector>& vecPoints, const Vector& vecCenter, float flRadius)
+{
+	int iFailures = 0;
+	std::vector<int> vecFound(vecPoints.size(), 0);
+	bool bDistances = true;
+
+	grid.ForEachInRange(vecCenter, flRadius, [&](int iIndex, float flDistSqr) {
+		vecFound[iIndex]++;
+		bDistances &= flDistSqr == Grid_DistSqr(vecPoints[iIndex], vecCenter);
+	});
+
+	int iWrong = 0;
+	uint64 iExpectedMask = 0;
+
+	for (int i = 0; i < vecPoints.size(); i++)
+	{
+		bool bInside = flRadius >= 0.0f && Grid_DistSqr(vecPoints[i], vecCenter) <= flRadius * flRadius;
+
+		if (vecFound[i] != (bInside ? 1 : 0))
+			iWrong++;
+
+		if (bInside && i < 64)
+			iExpectedMask |= 1ull << i;
+	}
+
+	HARNESS_CHECK(iWrong == 0, "%i of %i points wrong within %g of (%g %g %g)", iWrong, (int)vecPoints.size(), flRadius, vecCenter.x, vecCenter.y, vecCenter.z);
+	HARNESS_CHECK(bDistances, "distances differ from brute force");
+
+	if (vecPoints.size() <= 64)
+		HARNESS_CHECK(grid.QueryRangeMask(vecCenter, flRadius) == iExpectedMask, "range mask differs from brute force within %g", flRadius);
+
+	return iFailures;
+}
+
+static int Grid_CheckNearest(const CSpatialGrid& grid, const std::vector<Vector>& vecPoints, const Vector& vecCenter, int k, float flMaxRadius, int iIgnoreIndex)
+{
+	int iFailures = 0;
+	float flMaxDistSqr = flMaxRadius < sqrtf(FLT_MAX) ? flMaxRadius * flMaxRadius : FLT_MAX;
+	std::vector<float> vecExpected;
+
+	for (int i = 0; i < vecPoints.size(); i++)
+	{
+		float flDistSqr = Grid_DistSqr(vecPoints[i], vecCenter);
+
+		if (i != iIgnoreIndex && flDistSqr <= flMaxDistSqr)
+			vecExpected.push_back(flDistSqr);
+	}
+
+	std::sort(vecExpected.begin(), vecExpected.end());
+	vecExpected.resize(std::min<size_t>(vecExpected.size(), k));
+
+	std::vector<int> vecIndices(k);
+	std::vector<float> vecDistSqr(k);
+	int iFound = grid.QueryNearest(vecCenter, k, vecIndices.data(), vecDistSqr.data(), flMaxRadius, iIgnoreIndex);
+
+	HARNESS_CHECK(iFound == vecExpected.size(), "found %i of the %i nearest within %g", iFound, (int)vecExpected.size(), flMaxRadius);
+
+	if (iFound != vecExpected.size())
+		return iFailures;
+
+	// Ties can come back in any order, so only the distances are compared to brute force
+	int iWrong = 0;
+
+	for (int i = 0; i < iFound; i++)
+	{
+		if (vecDistSqr[i] != vecExpected[i] || vecIndices[i] == iIgnoreIndex || vecDistSqr[i] != Grid_DistSqr(vecPoints[vecIndices[i]], vecCenter))
+			iWrong++;
+	}
+
+	HARNESS_CHECK(iWrong == 0, "%i of the %i nearest points wrong", iWrong, iFound);
+
+	return iFailures;
+}
+
+int Test_SpatialGrid()
+{
+	int iFailures = 0;
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> radius(0.0f, 1500.0f);
+	std::vector<Vector> vecPoints;
+	CSpatialGrid grid;
+
+	// Nothing added yet
+	grid.Build();
+	HARNESS_CHECK(grid.QueryRangeMask(Vector(), 1000.0f) == 0, "empty grid returned points");
+
+	int k = 1;
+	int iIndex;
+	float flDistSqr;
+	HARNESS_CHECK(grid.QueryNearest(Vector(), k, &iIndex, &flDistSqr) == 0, "empty grid returned a nearest point");
+
+	const float flCellSizes[] = {64.0f, 512.0f, 4096.0f};
+	const int nPointCounts[] = {1, 7, 64, 300};
+
+	for (int iLayout = 0; iLayout < LAYOUT_COUNT; iLayout++)
+	{
+		for (float flCellSize : flCellSizes)
+		{
+			for (int nPoints : nPointCounts)
+			{
+				Grid_RandomPoints(vecPoints, nPoints, (EPointLayout)iLayout, rng);
+
+				grid.SetCellSize(flCellSize);
+				grid.Clear();
+
+				for (int i = 0; i < nPoints; i++)
+					grid.Add(i, vecPoints[i]);
+
+				grid.Build();
+
+				HARNESS_CHECK(grid.Count() == nPoints, "grid holds %i of %i points", grid.Count(), nPoints);
+
+				for (int n = 0; n < 50; n++)
+				{
+					// Mostly around the points themselves like hide distances, sometimes anywhere
+					Vector vecCenter = vecPoints[rng() % nPoints];
+
+					if (n % 5 == 0)
+						vecCenter = Vector(vecCenter.x + radius(rng) - 750.0f, vecCenter.y + radius(rng) - 750.0f, vecCenter.z);
+
+					iFailures += Grid_CheckRange(grid, vecPoints, vecCenter, radius(rng));
+					iFailures += Grid_CheckNearest(grid, vecPoints, vecCenter, 1 + rng() % 8, n % 2 ? radius(rng) : FLT_MAX, n % 3 ? -1 : rng() % nPoints);
+				}
+
+				Vector vecCenter = vecPoints[0];
+
+				iFailures += Grid_CheckRange(grid, vecPoints, vecCenter, 0.0f);
+				iFailures += Grid_CheckRange(grid, vecPoints, vecCenter, -1.0f);
+				iFailures += Grid_CheckRange(grid, vecPoints, vecCenter, 1e30f);
+				iFailures += Grid_CheckNearest(grid, vecPoints, vecCenter, nPoints + 5, FLT_MAX, -1);
+				iFailures += Grid_CheckNearest(grid, vecPoints, vecCenter, 3, 0.0f, 0);
+			}
+		}
+	}
+
+	return iFailures;
+}
+
+// 64 players at hide distances up to 1000, the grid against checking every pair like CheckHideDistances used to.
+// A grid with a single cell checks every pair too, but 4 at a time, which is the narrow phase on its own
+void Benchmark_SpatialGrid()
+{
+	const int iIterations = 20000;
+	std::mt19937 rng(iIterations);
+	std::uniform_int_distribution<int> distance(0, 1000);
+	std::vector<Vector> vecPoints;
+	float flRange[64];
+	uint64 iPairMasks[64];
+	uint64 iGridMasks[64];
+	uint64 iCellMasks[64];
+	CSpatialGrid grid(512.0f);
+	CSpatialGrid oneCell(1000000.0f);
+
+	for (int iLayout = LAYOUT_SPREAD; iLayout <= LAYOUT_CLUSTERED; iLayout++)
+	{
+		Grid_RandomPoints(vecPoints, 64, (EPointLayout)iLayout, rng);
+
+		for (int i = 0; i < 64; i++)
+			flRange[i] = distance(rng);
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		for (int n = 0; n < iIterations; n++)
+		{
+			for (int i = 0; i < 64; i++)
+			{
+				iPairMasks[i] = 0;
+
+				for (int j = 0; j < 64; j++)
+				{
+					if (j != i && Grid_DistSqr(vecPoints[j], vecPoints[i]) <= flRange[i] * flRange[i])
+						iPairMasks[i] |= 1ull << j;
+				}
+			}
+		}
+
+		auto pairsEnd = std::chrono::high_resolution_clock::now();
+
+		for (int n = 0; n < iIterations; n++)
+		{
+			oneCell.Clear();
+
+			for (int i = 0; i < 64; i++)
+				oneCell.Add(i, vecPoints[i]);
+
+			oneCell.Build();
+
+			for (int i = 0; i < 64; i++)
+				iCellMasks[i] = oneCell.QueryRangeMask(vecPoints[i], flRange[i]) & ~(1ull << i);
+		}
+
+		auto cellEnd = std::chrono::high_resolution_clock::now();
+
+		for (int n = 0; n < iIterations; n++)
+		{
+			grid.Clear();
+
+			for (int i = 0; i < 64; i++)
+				grid.Add(i, vecPoints[i]);
+
+			grid.Build();
+
+			for (int i = 0; i < 64; i++)
+				iGridMasks[i] = grid.QueryRangeMask(vecPoints[i], flRange[i]) & ~(1ull << i);
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+
+		int iMismatches = 0;
+
+		for (int i = 0; i < 64; i++)
+			iMismatches += (iPairMasks[i] != iGridMasks[i]) + (iPairMasks[i] != iCellMasks[i]);
+
+		printf("  %s: every pair %.1f ns, one cell %.1f ns, grid %.1f ns per check of 64 players, %i mismatching\n", iLayout == LAYOUT_SPREAD ? "spread" : "clustered",
+			   std::chrono::duration<double, std::nano>(pairsEnd - start).count() / iIterations,
+			   std::chrono::duration<double, std::nano>(cellEnd - pairsEnd).count() / iIterations,
+			   std::chrono::duration<double, std::nano>(end - cellEnd).count() / iIterations, iMismatches);
+	}
+}
@@ -0,0 +1,280 @@
+/**
+ * =============================================================================
+ * CS2Fixes
+ * Copyright (C) 2023-2025 Source2ZE
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "harness.h"
+#include "transmit_rules.h"
+#include <chrono>
+#include <random>
+#include <string.h>
+
+#define TRANSMIT_WORDS (TRANSMIT_MAX_EDICTS / 32)
+
+// Stand-ins for what Transmit_GatherScene reads from the controllers, pawns and ZEPlayers
+#define STUB_PAWN(slot) (100 + (slot))
+#define STUB_FLASHLIGHT(slot) (200 + (slot))
+#define STUB_ENTWATCH_HUD(slot) (300 + (slot))
+#define STUB_GLOW_MODEL(slot) (400 + (slot))
+
+// Everyone connected, alive and hiding nobody, with hide on like a typical ZE server
+static void Transmit_StubScene(TransmitScene_t& scene, int nPlayers)
+{
+	scene = {};
+	scene.iMaxClients = nPlayers;
+	scene.bHide = true;
+
+	for (int i = 0; i < nPlayers; i++)
+	{
+		TransmitPlayer_t& player = scene.players[i];
+		player.bValid = player.bViewer = player.bAlive = true;
+		player.iPawn = STUB_PAWN(i);
+		player.iFlashLight = player.iEntwatchHud = player.iGlowModel = -1;
+	}
+}
+
+// Whether iEntity ends up hidden from iViewer, or -1 if the masks and the per-entity rules disagree
+static int Transmit_IsHidden(const TransmitScene_t& scene, int iViewer, int iEntity)
+{
+	static TransmitShared_t shared;
+	static CTransmitMask mask;
+	static uint32_t reference[TRANSMIT_WORDS];
+
+	memset(reference, 0xFF, sizeof(reference));
+	Transmit_ApplyReference(scene, iViewer, reference);
+
+	Transmit_BuildShared(scene, shared);
+	Transmit_BuildMask(scene, shared, iViewer, mask);
+
+	bool bReference = !(reference[iEntity >> 5] & (1u << (iEntity & 31)));
+
+	return bReference == mask.IsSet(iEntity) ? bReference : -1;
+}
+
+// Random scenes with entity indices packed into a small range so masks share words a lot, but never used twice like real entities
+static void Transmit_RandomScene(TransmitScene_t& scene, std::mt19937& rng, int (*pClearLists)[16])
+{
+	int iNextEntity = 1;
+	auto chance = [&rng](int iPercent) { return (int)(rng() % 100) < iPercent; };
+	auto entity = [&](int iPercent) { return chance(iPercent) ? (iNextEntity += 1 + rng() % 8) : -1; };
+
+	scene.iMaxClients = TRANSMIT_MAX_PLAYERS;
+	scene.bHide = chance(80);
+	scene.bHideDead = chance(50);
+	scene.bFlashLightTransmitOthers = chance(20);
+
+	for (int i = 0; i < TRANSMIT_MAX_PLAYERS; i++)
+	{
+		TransmitPlayer_t& player = scene.players[i];
+
+		player.bValid = chance(90);
+		player.bViewer = player.bValid && chance(90);
+		player.bObserver = chance(10);
+		player.bHoldingRMB = chance(10);
+		player.bAlive = chance(70);
+		player.bLeader = chance(5);
+		player.bBeacon = chance(5);
+		player.iPawn = entity(90);
+		player.iFlashLight = entity(30);
+		player.iEntwatchHud = entity(20);
+		player.iGlowModel = entity(10);
+		player.iBlockMask = ((uint64_t)rng() << 32) | rng();
+		player.iForceTransmitMask = chance(30) ? ((uint64_t)rng() << 32) | rng() : 0;
+
+		for (int j = 0; j < 16; j++)
+			pClearLists[i][j] = chance(20) ? (int)(rng() % 4096) - 64 : 0;
+
+		player.pClearList = pClearLists[i];
+		player.nClearList = 16;
+	}
+}
+
+// Viewers whose transmit list comes out different from the masks than from the per-entity rules, starting from random lists
+static int Transmit_VerifyScene(const TransmitScene_t& scene, std::mt19937& rng)
+{
+	static uint32_t expected[TRANSMIT_WORDS], actual[TRANSMIT_WORDS];
+	static TransmitShared_t shared;
+	static CTransmitMask mask;
+	int iMismatches = 0;
+
+	Transmit_BuildShared(scene, shared);
+
+	for (int i = 0; i < scene.iMaxClients; i++)
+	{
+		for (int j = 0; j < TRANSMIT_WORDS; j++)
+			expected[j] = rng();
+
+		memcpy(actual, expected, sizeof(actual));
+
+		Transmit_ApplyReference(scene, i, expected);
+		Transmit_BuildMask(scene, shared, i, mask);
+		mask.RemoveFrom(actual);
+
+		if (memcmp(actual, expected, sizeof(actual)) != 0)
+			iMismatches++;
+	}
+
+	return iMismatches;
+}
+
+int Test_Transmit()
+{
+	int iFailures = 0;
+	static TransmitScene_t scene;
+
+	// Hide distance
+	Transmit_StubScene(scene, 4);
+	scene.players[0].iBlockMask = (1ull << 1) | (1ull << 0);
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(1)) == 1, "blocked player is transmitted");
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(2)) == 0, "player outside the hide distance is hidden");
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(0)) == 0, "own pawn is hidden");
+	HARNESS_CHECK(Transmit_IsHidden(scene, 1, STUB_PAWN(0)) == 0, "hide distance applied to the wrong viewer");
+
+	scene.players[0].bHoldingRMB = true;
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(1)) == 0, "hidden while holding RMB");
+
+	scene.players[0].bHoldingRMB = false;
+	scene.players[0].bObserver = true;
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(1)) == 0, "hidden while spectating");
+
+	scene.players[0].bObserver = false;
+	scene.bHide = false;
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(1)) == 0, "hidden with hide turned off");
+
+	scene.bHide = true;
+	scene.players[0].iForceTransmitMask = 1ull << 1;
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(1)) == 0, "hidden although the C# side forces it");
+
+	scene.players[0].iForceTransmitMask = 0;
+	scene.players[0].bViewer = false;
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(1)) == 0, "rules applied to a player without a ZEPlayer");
+
+	// Leaders and beacons
+	Transmit_StubScene(scene, 4);
+	scene.players[0].iBlockMask = (1ull << 1) | (1ull << 2);
+	scene.players[1].bLeader = true;
+	scene.players[2].bBeacon = true;
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(1)) == 0, "leader is hidden");
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(2)) == 0, "player with a beacon is hidden");
+
+	// Dead players
+	Transmit_StubScene(scene, 4);
+	scene.players[1].bAlive = false;
+	scene.players[1].bLeader = true;
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(1)) == 0, "dead player hidden with hide dead off");
+
+	scene.bHideDead = true;
+	scene.players[0].iForceTransmitMask = 1ull << 1;
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_PAWN(1)) == 1, "dead player transmitted with hide dead on");
+
+	// Flashlights, entwatch hud and glow models
+	Transmit_StubScene(scene, 4);
+	scene.players[1].iFlashLight = STUB_FLASHLIGHT(1);
+	scene.players[1].iEntwatchHud = STUB_ENTWATCH_HUD(1);
+	scene.players[1].iGlowModel = STUB_GLOW_MODEL(1);
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_FLASHLIGHT(1)) == 1, "flashlight transmitted to others");
+	HARNESS_CHECK(Transmit_IsHidden(scene, 1, STUB_FLASHLIGHT(1)) == 0, "flashlight hidden from its owner");
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_ENTWATCH_HUD(1)) == 1, "entwatch hud transmitted to others");
+	HARNESS_CHECK(Transmit_IsHidden(scene, 1, STUB_ENTWATCH_HUD(1)) == 0, "entwatch hud hidden from its owner");
+	HARNESS_CHECK(Transmit_IsHidden(scene, 1, STUB_GLOW_MODEL(1)) == 1, "glow model transmitted to its owner");
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_GLOW_MODEL(1)) == 0, "glow model hidden from others");
+
+	scene.bFlashLightTransmitOthers = true;
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_FLASHLIGHT(1)) == 0, "flashlight hidden with cs2f_flashlight_transmit_others on");
+
+	scene.players[1].bValid = false;
+	scene.bFlashLightTransmitOthers = false;
+	HARNESS_CHECK(Transmit_IsHidden(scene, 0, STUB_ENTWATCH_HUD(1)) == 0, "entwatch hud of an HLTV slot hidden");
+
+	// C# clear lists
+	Transmit_StubScene(scene, 4);
+	int clearList[] = {0, 1000, -5};
+	scene.players[2].pClearList = clearList;
+	scene.players[2].nClearList = 3;
+	HARNESS_CHECK(Transmit_IsHidden(scene, 2, 1000) == 1, "entity from the clear list transmitted");
+	HARNESS_CHECK(Transmit_IsHidden(scene, 2, 0) == 0, "clear list entry 0 hides the world");
+	HARNESS_CHECK(Transmit_IsHidden(scene, 1, 1000) == 0, "clear list applied to the wrong viewer");
+
+	// And the masks against the per-entity rules on anything else
+	std::mt19937 rng(1);
+	static int clearLists[TRANSMIT_MAX_PLAYERS][16];
+	int iMismatches = 0;
+
+	for (int i = 0; i < 500; i++)
+	{
+		Transmit_RandomScene(scene, rng, clearLists);
+		iMismatches += Transmit_VerifyScene(scene, rng);
+	}
+
+	HARNESS_CHECK(iMismatches == 0, "%i viewers of 500 random scenes differ from the per-entity rules", iMismatches);
+
+	return iFailures;
+}
+
+// Replays random scenes through both the per-entity rules and the masks, like CheckTransmit would for 64 viewers
+void Benchmark_Transmit()
+{
+	const int iTicks = 20000;
+	std::mt19937 rng(iTicks);
+
+	// A handful of distinct scenes so consecutive ticks don't hit the exact same data
+	static TransmitScene_t scenes[16];
+	static int clearLists[16][TRANSMIT_MAX_PLAYERS][16];
+	static uint32_t transmit[TRANSMIT_MAX_PLAYERS][TRANSMIT_WORDS];
+	static TransmitShared_t shared;
+	static CTransmitMask masks[TRANSMIT_MAX_PLAYERS];
+
+	for (int i = 0; i < 16; i++)
+		Transmit_RandomScene(scenes[i], rng, clearLists[i]);
+
+	std::chrono::duration<double, std::nano> reference{}, build{}, apply{};
+
+	for (int n = 0; n < iTicks; n++)
+	{
+		const TransmitScene_t& scene = scenes[n % 16];
+
+		memset(transmit, 0xFF, sizeof(transmit));
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		for (int i = 0; i < TRANSMIT_MAX_PLAYERS; i++)
+			Transmit_ApplyReference(scene, i, transmit[i]);
+
+		auto middle = std::chrono::high_resolution_clock::now();
+
+		Transmit_BuildShared(scene, shared);
+
+		for (int i = 0; i < TRANSMIT_MAX_PLAYERS; i++)
+			Transmit_BuildMask(scene, shared, i, masks[i]);
+
+		auto built = std::chrono::high_resolution_clock::now();
+
+		for (int i = 0; i < TRANSMIT_MAX_PLAYERS; i++)
+			masks[i].RemoveFrom(transmit[i]);
+
+		auto end = std::chrono::high_resolution_clock::now();
+
+		reference += middle - start;
+		build += built - middle;
+		apply += end - built;
+	}
+
+	double flScale = 1.0 / ((double)iTicks * TRANSMIT_MAX_PLAYERS);
+
+	printf("  per-entity rules: %.1f ns per viewer per tick\n", reference.count() * flScale);
+	printf("  masks: %.1f ns per viewer per tick (%.1f building, %.1f applying)\n", (build + apply).count() * flScale, build.count() * flScale, apply.count() * flScale);
+}